@@ -0,0 +1,50 @@
+#!/bin/sh
+# Batch throughput on 1, 2, 4, 8 and 16 threads: builds the program, generates a bank and a file of
+# deposits, withdrawals and transfers, then runs --batch on a fresh copy of the bank for each thread count
+# and reports operations per second from the time the batch took to apply.
+# Run from the repository root: sh bench/batch_bench.sh [accounts] [operations]
+
+set -e
+accounts=${1:-100000}
+operations=${2:-1000000}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+gcc -O2 -pthread -o "$dir/bank" main.c -lm
+
+awk -v n="$accounts" 'BEGIN {
+    printf "{\"accounts\":["
+    for (i = 0; i < n; i++) {
+        printf "%s{\"name\":\"Name %d\",\"country\":\"IN\",\"state\":\"TS\",\"city\":\"Hyd\",\"street\":\"Main\",", \
+            i ? "," : "", i
+        printf "\"houseNumber\":\"%d\",\"phone\":\"9999\",\"pin\":\"1234\",\"securityQuestion\":\"pet?\",", i
+        printf "\"securityAnswer\":\"dog\",\"accountNumber\":%d,\"balance\":%d.%02d}", 10000000 + i, 1000 + i % 9000, i % 100
+    }
+    printf "],\"journalSeq\":0}\n"
+}' > "$dir/bank.json"
+
+awk -v n="$accounts" -v ops="$operations" 'BEGIN {
+    srand(1)
+    for (i = 0; i < ops; i++) {
+        account = 10000000 + int(rand() * n)
+        kind = int(rand() * 3)
+        if (kind == 0) {
+            printf "D %d %d.%02d\n", account, 1 + int(rand() * 500), int(rand() * 100)
+        } else if (kind == 1) {
+            printf "W %d %d.%02d\n", account, 1 + int(rand() * 50), int(rand() * 100)
+        } else {
+            printf "T %d %d %d.%02d\n", account, 10000000 + int(rand() * n), 1 + int(rand() * 50), int(rand() * 100)
+        }
+    }
+}' > "$dir/ops.txt"
+
+echo "$accounts accounts, $operations operations, $(nproc) CPUs"
+for threads in 1 2 4 8 16; do
+    cp "$dir/bank.json" "$dir/accounts.json"
+    rm -f "$dir/accounts.journal"
+    summary=$(cd "$dir" && ./bank --batch=ops.txt --out=results.txt --threads=$threads 2>&1 >/dev/null | grep '^Batch:')
+    # Batch: N operations, F failed, in T ms (A ms to apply on K threads)
+    echo "$summary" | awk -v threads="$threads" -v ops="$operations" '{
+        applied = $(NF - 6); sub(/^\(/, "", applied)
+        printf "%2d threads  %8.1f ms to apply  %10.0f ops/s\n", threads, applied, ops / (applied / 1000)
+    }'
+done
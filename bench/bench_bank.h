@@ -0,0 +1,31 @@
+/*
+   Shared by the benchmarks: the program itself, with its main() renamed so a benchmark can have its own, a
+   monotonic clock, and a synthetic bank to run on.
+*/
+#ifndef BENCH_BANK_H
+#define BENCH_BANK_H
+
+#define main bankMain
+#include "../main.c"
+#undef main
+
+double seconds() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double) time.tv_sec + (double) time.tv_nsec / 1e9;
+}
+
+// Fills the table with accounts numbered from ACCOUNT_NUMBER_MIN up. Names carry quotes so encoders have to escape.
+void benchBank(AccountTable *table, size_t accounts) {
+    for (size_t i = 0; i < accounts; i++) {
+        char name[32], house[16];
+        snprintf(name, sizeof(name), "Name \"%zu\"", i);
+        snprintf(house, sizeof(house), "%zu", i % 1000);
+        const char *values[ACCOUNT_STRING_FIELDS] = {
+            name, "India", "Telangana", "Hyderabad", "Main Road", house, "9876543210", "1234", "First pet?", "Dog"
+        };
+        tableAdd(table, ACCOUNT_NUMBER_MIN + (int) i, (long long) (i * 7919 % 10000000), values);
+    }
+}
+
+#endif
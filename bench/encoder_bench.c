@@ -0,0 +1,92 @@
+/*
+   Save throughput of the schema encoder (saveToFile) against cJSON_Print/cJSON_PrintUnformatted on the equivalent
+   cJSON document, for the pretty and compact layouts, on a synthetic bank. Both write to /dev/null; the cJSON side
+   includes the write of its printed buffer. The encoder's output is first checked byte for byte against cJSON's.
+   Best of 5 runs.
+   Build and run from the repository root:
+    gcc -O2 -pthread -o encoder_bench bench/encoder_bench.c -lm && ./encoder_bench [accounts]
+*/
+#include "bench_bank.h"
+
+#define RUNS 5
+
+// The document cJSON would have printed for the table, keys in the order the encoder writes them
+cJSON *tableToJSON(const AccountTable *table) {
+    cJSON *json = cJSON_CreateObject();
+    cJSON *accounts = cJSON_AddArrayToObject(json, KEY_ACCOUNTS);
+    for (size_t row = 0; row < table->count; row++) {
+        cJSON *account = cJSON_CreateObject();
+        for (int field = 0; field < ACCOUNT_STRING_FIELDS; field++) {
+            cJSON_AddStringToObject(account, ACCOUNT_STRING_KEYS[field], tableString(table, row, field));
+        }
+        cJSON_AddNumberToObject(account, KEY_ACCOUNT_NUMBER, table->accountNumbers[row]);
+        cJSON_AddNumberToObject(account, KEY_BALANCE, (double) table->balances[row] / MINOR_UNITS);
+        cJSON_AddItemToArray(accounts, account);
+    }
+    cJSON_AddNumberToObject(json, KEY_JOURNAL_SEQ, (double) table->journalSeq);
+    return json;
+}
+
+int main(int argc, char *argv[]) {
+    size_t accounts = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    encoderInit();
+
+    AccountTable table = { 0 };
+    benchBank(&table, accounts);
+    table.journalSeq = 42;
+    cJSON *json = tableToJSON(&table);
+
+    int null = open("/dev/null", O_WRONLY);
+    char path[] = "/tmp/encoder_benchXXXXXX";
+    int fd = mkstemp(path);
+    if (null < 0 || fd < 0) {
+        perror("Error opening file. Function main()");
+        return EXIT_FAILURE;
+    }
+    unlink(path);
+
+    const char *names[] = { "pretty", "compact" };
+    printf("%zu accounts, best of %d\n", accounts, RUNS);
+    for (StorageFormat format = FORMAT_PRETTY; format <= FORMAT_COMPACT; format++) {
+        storageFormat = format;
+
+        char *printed = format == FORMAT_PRETTY ? cJSON_Print(json) : cJSON_PrintUnformatted(json);
+        size_t length = strlen(printed);
+        if (ftruncate(fd, 0) != 0 || lseek(fd, 0, SEEK_SET) != 0 || saveToFile(&table, fd) != length) {
+            fprintf(stderr, "%s: the encoder and cJSON disagree on the length\n", names[format]);
+            return EXIT_FAILURE;
+        }
+        char *encoded = malloc(length);
+        if (encoded == NULL || pread(fd, encoded, length, 0) != (ssize_t) length ||
+            memcmp(encoded, printed, length) != 0) {
+            fprintf(stderr, "%s: the encoder and cJSON disagree on the bytes\n", names[format]);
+            return EXIT_FAILURE;
+        }
+        free(encoded);
+        cJSON_free(printed);
+
+        double encoderBest = 1e9, cJSONBest = 1e9;
+        for (int run = 0; run < RUNS; run++) {
+            double start = seconds();
+            saveToFile(&table, null);
+            double elapsed = seconds() - start;
+            encoderBest = elapsed < encoderBest ? elapsed : encoderBest;
+
+            start = seconds();
+            printed = format == FORMAT_PRETTY ? cJSON_Print(json) : cJSON_PrintUnformatted(json);
+            writeAll(null, printed, strlen(printed));
+            cJSON_free(printed);
+            elapsed = seconds() - start;
+            cJSONBest = elapsed < cJSONBest ? elapsed : cJSONBest;
+        }
+        printf("  %-8s %7.1f MB  saveToFile %7.1f ms (%6.1f MB/s)  cJSON %7.1f ms (%6.1f MB/s)\n", names[format],
+               (double) length / 1e6, encoderBest * 1000, (double) length / 1e6 / encoderBest, cJSONBest * 1000,
+               (double) length / 1e6 / cJSONBest);
+    }
+
+    close(fd);
+    close(null);
+    cJSON_Delete(json);
+    tableFree(&table);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,61 @@
+/*
+   Snapshot size, save time and load time for each --format on a synthetic bank. Saving is the checkpoint path
+   (snapshotCreate, saveToFile, snapshotCommit with its fsync); loading is loadFromFile into an empty table.
+   Runs in a temporary directory. Best of 3 runs.
+   Build and run from the repository root:
+    gcc -O2 -pthread -o format_bench bench/format_bench.c -lm && ./format_bench [accounts]
+*/
+#include "bench_bank.h"
+
+#define RUNS 3
+
+int main(int argc, char *argv[]) {
+    size_t accounts = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    encoderInit();
+
+    AccountTable table = { 0 };
+    benchBank(&table, accounts);
+
+    char directory[] = "/tmp/format_benchXXXXXX";
+    if (mkdtemp(directory) == NULL || chdir(directory) != 0) {
+        perror("Error creating directory. Function main()");
+        return EXIT_FAILURE;
+    }
+
+    const char *names[] = { "pretty", "compact", "jsonl" };
+    printf("%zu accounts, best of %d\n", accounts, RUNS);
+    for (StorageFormat format = FORMAT_PRETTY; format <= FORMAT_JSONL; format++) {
+        storageFormat = format;
+        size_t bytes = 0;
+        double saveBest = 1e9, loadBest = 1e9;
+        for (int run = 0; run < RUNS; run++) {
+            double start = seconds();
+            int fd = snapshotCreate();
+            bytes = saveToFile(&table, fd);
+            snapshotCommit(fd, JSON_FILE);
+            double saved = seconds() - start;
+            saveBest = saved < saveBest ? saved : saveBest;
+
+            AccountTable loaded = { 0 };
+            start = seconds();
+            loadFromFile(JSON_FILE, &loaded);
+            double load = seconds() - start;
+            loadBest = load < loadBest ? load : loadBest;
+            if (loaded.count != table.count) {
+                fprintf(stderr, "Loaded %zu accounts instead of %zu\n", loaded.count, table.count);
+                return EXIT_FAILURE;
+            }
+            tableFree(&loaded);
+        }
+        printf("  %-8s %8.1f MB  save %7.1f ms  load %7.1f ms\n", names[format], (double) bytes / 1e6,
+               saveBest * 1000, loadBest * 1000);
+    }
+
+    unlink(JSON_FILE);
+    if (chdir("/") == 0) {
+        rmdir(directory);
+    }
+    indexFree();
+    tableFree(&table);
+    return EXIT_SUCCESS;
+}
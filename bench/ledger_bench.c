@@ -0,0 +1,129 @@
+/*
+   Posting and aggregation throughput on a million-row ledger, balances held as double units (the old Account.balance)
+   against whole cents in long long (the account table's balances column):
+    scattered posting  10M postings to random rows, the shape of a batch of deposits and withdrawals
+    bulk posting       one amount per row added over every row, which the compiler can vectorize
+    sum                the total of all balances
+   The totals of both ledgers are printed, so the drift of the double ledger shows next to the exact one.
+   Best of 5 runs.
+   Build and run from the repository root:
+    gcc -O2 -pthread -o ledger_bench bench/ledger_bench.c -lm && ./ledger_bench
+*/
+#include "bench_bank.h"
+
+#define ROWS 1000000
+#define POSTINGS 10000000
+#define RUNS 5
+
+void report(const char *name, const double best[2]) {
+    printf("  %-18s double %7.2f ms  cents %7.2f ms\n", name, best[0] * 1000, best[1] * 1000);
+}
+
+int main() {
+    double *doubles = malloc(ROWS * sizeof(double));
+    long long *cents = malloc(ROWS * sizeof(long long));
+    double *rowDoubles = malloc(ROWS * sizeof(double));
+    long long *rowCents = malloc(ROWS * sizeof(long long));
+    unsigned *postingRows = malloc(POSTINGS * sizeof(unsigned));
+    double *postingDoubles = malloc(POSTINGS * sizeof(double));
+    long long *postingCents = malloc(POSTINGS * sizeof(long long));
+    if (doubles == NULL || cents == NULL || rowDoubles == NULL || rowCents == NULL || postingRows == NULL ||
+        postingDoubles == NULL || postingCents == NULL) {
+        perror("Error allocating memory. Function main()");
+        return EXIT_FAILURE;
+    }
+
+    // Amounts between -500.00 and 500.00, the same values in both representations
+    unsigned long long state = 1;
+    for (size_t i = 0; i < POSTINGS; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        postingRows[i] = (unsigned) ((state >> 33) % ROWS);
+        postingCents[i] = (long long) ((state >> 11) % 100001) - 50000;
+        postingDoubles[i] = (double) postingCents[i] / MINOR_UNITS;
+    }
+    for (size_t i = 0; i < ROWS; i++) {
+        rowCents[i] = (long long) (i % 997) + 1;
+        rowDoubles[i] = (double) rowCents[i] / MINOR_UNITS;
+    }
+
+    double scattered[2] = { 1e9, 1e9 }, bulk[2] = { 1e9, 1e9 }, sum[2] = { 1e9, 1e9 };
+    double doubleTotal = 0;
+    long long centsTotal = 0;
+    for (int run = 0; run < RUNS; run++) {
+        for (size_t i = 0; i < ROWS; i++) {
+            doubles[i] = 1000.10;
+            cents[i] = 100010;
+        }
+
+        double start = seconds();
+        for (size_t i = 0; i < POSTINGS; i++) {
+            doubles[postingRows[i]] += postingDoubles[i];
+        }
+        double elapsed = seconds() - start;
+        scattered[0] = elapsed < scattered[0] ? elapsed : scattered[0];
+        start = seconds();
+        for (size_t i = 0; i < POSTINGS; i++) {
+            cents[postingRows[i]] += postingCents[i];
+        }
+        elapsed = seconds() - start;
+        scattered[1] = elapsed < scattered[1] ? elapsed : scattered[1];
+
+        start = seconds();
+        for (size_t i = 0; i < ROWS; i++) {
+            doubles[i] += rowDoubles[i];
+        }
+        elapsed = seconds() - start;
+        bulk[0] = elapsed < bulk[0] ? elapsed : bulk[0];
+        start = seconds();
+        for (size_t i = 0; i < ROWS; i++) {
+            cents[i] += rowCents[i];
+        }
+        elapsed = seconds() - start;
+        bulk[1] = elapsed < bulk[1] ? elapsed : bulk[1];
+
+        start = seconds();
+        doubleTotal = 0;
+        for (size_t i = 0; i < ROWS; i++) {
+            doubleTotal += doubles[i];
+        }
+        elapsed = seconds() - start;
+        sum[0] = elapsed < sum[0] ? elapsed : sum[0];
+        start = seconds();
+        centsTotal = 0;
+        for (size_t i = 0; i < ROWS; i++) {
+            centsTotal += cents[i];
+        }
+        elapsed = seconds() - start;
+        sum[1] = elapsed < sum[1] ? elapsed : sum[1];
+    }
+
+    printf("%d rows, %d postings, best of %d\n", ROWS, POSTINGS, RUNS);
+    report("scattered posting", scattered);
+    report("bulk posting", bulk);
+    report("sum", sum);
+
+    // Rows whose double balance has drifted from the double nearest the exact amount, and those off by a whole cent
+    size_t driftedRows = 0, wrongRows = 0;
+    for (size_t i = 0; i < ROWS; i++) {
+        long long rounded;
+        if (doubles[i] != (double) cents[i] / MINOR_UNITS) {
+            driftedRows++;
+        }
+        if (!amountFromDouble(doubles[i], &rounded) || rounded != cents[i]) {
+            wrongRows++;
+        }
+    }
+    char exact[AMOUNT_LENGTH];
+    formatAmount(centsTotal, exact, 1);
+    printf("  total              double %.17g  cents %s\n", doubleTotal, exact);
+    printf("  rows drifted       %zu, %zu of them off by a cent or more\n", driftedRows, wrongRows);
+
+    free(doubles);
+    free(cents);
+    free(rowDoubles);
+    free(rowCents);
+    free(postingRows);
+    free(postingDoubles);
+    free(postingCents);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,73 @@
+/*
+   Number parsing throughput: parse_number_fast against the strtod path parse_number used before it (copy the
+   number into a terminated stack buffer, then strtod), on 1M account numbers and 1M cent balances as they appear
+   in a snapshot. Best of 15 runs.
+   Build and run from the repository root:
+    gcc -O2 -pthread -o number_bench bench/number_bench.c -lm && ./number_bench
+*/
+#include "bench_bank.h"
+
+#define COUNT 2000000
+#define RUNS 15
+
+// The old parse_number: copy the characters a number can have, then strtod
+double parseWithStrtod(const unsigned char *input, size_t length) {
+    char copy[64];
+    size_t i = 0;
+    for (; i < sizeof(copy) - 1 && i < length && strchr("0123456789+-eE.", input[i]) != NULL; i++) {
+        copy[i] = (char) input[i];
+    }
+    copy[i] = '\0';
+    return strtod(copy, NULL);
+}
+
+int main() {
+    // Numbers separated by commas, like the values of a snapshot
+    char *text = malloc((size_t) COUNT * 24);
+    size_t *offsets = malloc(COUNT * sizeof(size_t));
+    size_t length = 0;
+    srand(1);
+    for (int i = 0; i < COUNT; i++) {
+        offsets[i] = length;
+        if (i % 2 == 0) {
+            length += (size_t) sprintf(text + length, "%d,", 10000000 + rand() % 90000000);
+        } else {
+            length += (size_t) sprintf(text + length, "%d.%02d,", rand() % 100000, rand() % 100);
+        }
+    }
+
+    double best[2] = { 1e9, 1e9 };
+    double sums[2] = { 0, 0 };
+    for (int run = 0; run < RUNS; run++) {
+        double start = seconds();
+        double sum = 0;
+        for (int i = 0; i < COUNT; i++) {
+            double number = 0;
+            parse_number_fast((const unsigned char *) text + offsets[i], length - offsets[i], &number);
+            sum += number;
+        }
+        double elapsed = seconds() - start;
+        best[0] = elapsed < best[0] ? elapsed : best[0];
+        sums[0] = sum;
+
+        start = seconds();
+        sum = 0;
+        for (int i = 0; i < COUNT; i++) {
+            sum += parseWithStrtod((const unsigned char *) text + offsets[i], length - offsets[i]);
+        }
+        elapsed = seconds() - start;
+        best[1] = elapsed < best[1] ? elapsed : best[1];
+        sums[1] = sum;
+    }
+
+    printf("%d numbers (half account numbers, half balances), best of %d\n", COUNT, RUNS);
+    printf("  parse_number_fast  %.3f s  %.1f M numbers/s\n", best[0], COUNT / best[0] / 1e6);
+    printf("  copy + strtod      %.3f s  %.1f M numbers/s\n", best[1], COUNT / best[1] / 1e6);
+    if (sums[0] != sums[1]) {
+        printf("MISMATCH: sums differ\n");
+        return EXIT_FAILURE;
+    }
+    free(text);
+    free(offsets);
+    return EXIT_SUCCESS;
+}
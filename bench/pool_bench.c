@@ -0,0 +1,83 @@
+/*
+   Load and teardown of a parsed snapshot with cJSON's default hooks (malloc/free) against the slab allocator
+   (poolMalloc/poolFree): parse a compact snapshot of a synthetic bank with cJSON_ParseWithLength, then tear it down
+   with cJSON_Delete, or with poolRelease() in one pass. Best of 5 runs.
+   Build and run from the repository root:
+    gcc -O2 -pthread -o pool_bench bench/pool_bench.c -lm && ./pool_bench [accounts]
+*/
+#include "bench_bank.h"
+
+#define RUNS 5
+
+// Writes a compact snapshot of a bank with the given number of accounts to a temporary file and reads it back
+char *benchSnapshot(size_t accounts, size_t *length) {
+    AccountTable table = { 0 };
+    benchBank(&table, accounts);
+
+    char path[] = "/tmp/pool_benchXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("Error creating file. Function benchSnapshot()");
+        exit(EXIT_FAILURE);
+    }
+    storageFormat = FORMAT_COMPACT;
+    *length = saveToFile(&table, fd);
+    tableFree(&table);
+
+    char *text = malloc(*length);
+    if (text == NULL || pread(fd, text, *length, 0) != (ssize_t) *length) {
+        perror("Error reading file. Function benchSnapshot()");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+    unlink(path);
+    return text;
+}
+
+int main(int argc, char *argv[]) {
+    size_t accounts = argc > 1 ? strtoul(argv[1], NULL, 10) : 500000;
+    encoderInit();
+    size_t length;
+    char *text = benchSnapshot(accounts, &length);
+
+    cJSON_Hooks pooled = { poolMalloc, poolFree };
+    const char *names[2] = { "malloc/free", "slab pool" };
+    printf("%zu accounts, %.1f MB compact snapshot, best of %d\n", accounts, (double) length / 1e6, RUNS);
+    for (int usePool = 0; usePool <= 1; usePool++) {
+        double parseBest = 1e9, deleteBest = 1e9, releaseBest = 1e9;
+        for (int run = 0; run < RUNS; run++) {
+            cJSON_InitHooks(usePool ? &pooled : NULL);
+            double start = seconds();
+            cJSON *json = cJSON_ParseWithLength(text, length);
+            double parsed = seconds();
+            if (json == NULL) {
+                fprintf(stderr, "Error parsing the snapshot\n");
+                return EXIT_FAILURE;
+            }
+            parseBest = parsed - start < parseBest ? parsed - start : parseBest;
+
+            // The pool is timed both ways: node by node like the default hooks, and dropped whole
+            if (usePool && run % 2 == 1) {
+                start = seconds();
+                poolRelease();
+                double released = seconds() - start;
+                releaseBest = released < releaseBest ? released : releaseBest;
+            } else {
+                start = seconds();
+                cJSON_Delete(json);
+                double deleted = seconds() - start;
+                deleteBest = deleted < deleteBest ? deleted : deleteBest;
+                poolRelease();
+            }
+        }
+        printf("  %-12s parse %7.1f ms  cJSON_Delete %7.1f ms", names[usePool], parseBest * 1000,
+               deleteBest * 1000);
+        if (usePool) {
+            printf("  poolRelease %7.1f ms", releaseBest * 1000);
+        }
+        printf("\n");
+    }
+    cJSON_InitHooks(NULL);
+    free(text);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+/*
+   Throughput of high-volume internal transfers of 0.01 between random accounts of a synthetic bank:
+    journaled  the menu path: balances updated under bankMutex, then journalCommit() waits for the group-committed
+               fsync. A transfer is one T record; the old way was a withdrawal and a deposit, two records and two
+               commits. Run on 1 and 32 threads, each making the given number of transfers; journal bytes are per
+               transfer.
+    batch      --batch on one thread: T lines against the same transfers as W and D line pairs, snapshot included.
+               The total money in the bank is checked to be unchanged after the T batch.
+   Runs in a temporary directory, so the fsyncs hit that directory's file system.
+   Build and run from the repository root:
+    gcc -O2 -pthread -o transfer_bench bench/transfer_bench.c -lm && ./transfer_bench [accounts] [transfers per thread] [batch transfers]
+*/
+#include "bench_bank.h"
+
+typedef struct {
+    AccountTable *table;
+    size_t accounts;
+    size_t transfers;
+    int pairs; // A withdrawal plus a deposit instead of one transfer
+    unsigned long long seed;
+} TransferWorker;
+
+void *transferWorkerRun(void *arg) {
+    TransferWorker *worker = arg;
+    AccountTable *table = worker->table;
+    for (size_t i = 0; i < worker->transfers; i++) {
+        worker->seed = worker->seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t row = (size_t) (worker->seed >> 33) % worker->accounts;
+        size_t toRow = (row + 1 + (size_t) (worker->seed >> 13) % (worker->accounts - 1)) % worker->accounts;
+
+        pthread_mutex_lock(&bankMutex);
+        if (table->balances[row] < 1) {
+            pthread_mutex_unlock(&bankMutex);
+            continue;
+        }
+        table->balances[row] -= 1;
+        unsigned long long seq;
+        if (worker->pairs) {
+            seq = journalBalance('W', table->accountNumbers[row], 1, table->balances[row]);
+            pthread_mutex_unlock(&bankMutex);
+            journalCommit(seq);
+            pthread_mutex_lock(&bankMutex);
+            table->balances[toRow] += 1;
+            seq = journalBalance('D', table->accountNumbers[toRow], 1, table->balances[toRow]);
+        } else {
+            table->balances[toRow] += 1;
+            seq = journalTransfer(table->accountNumbers[row], table->accountNumbers[toRow], 1, table->balances[row],
+                                  table->balances[toRow]);
+        }
+        pthread_mutex_unlock(&bankMutex);
+        journalCommit(seq);
+    }
+    return NULL;
+}
+
+long long bankTotal(const AccountTable *table) {
+    long long total = 0;
+    for (size_t row = 0; row < table->count; row++) {
+        total += table->balances[row];
+    }
+    return total;
+}
+
+int main(int argc, char *argv[]) {
+    size_t accounts = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    size_t perThread = argc > 2 ? strtoul(argv[2], NULL, 10) : 200;
+    size_t batchTransfers = argc > 3 ? strtoul(argv[3], NULL, 10) : 1000000;
+    encoderInit();
+
+    char directory[] = "/tmp/transfer_benchXXXXXX";
+    if (mkdtemp(directory) == NULL || chdir(directory) != 0) {
+        perror("Error creating directory. Function main()");
+        return EXIT_FAILURE;
+    }
+    AccountTable table = { 0 };
+    benchBank(&table, accounts);
+    indexBuild(&table);
+    journalOpen(JOURNAL_FILE);
+    journalStart();
+
+    printf("%zu accounts\n", accounts);
+    const size_t threadCounts[] = { 1, 32 };
+    for (size_t i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); i++) {
+        size_t threads = threadCounts[i];
+        double rates[2];
+        size_t bytes[2];
+        for (int pairs = 0; pairs <= 1; pairs++) {
+            TransferWorker workers[32];
+            for (size_t thread = 0; thread < threads; thread++) {
+                workers[thread] = (TransferWorker) { &table, accounts, perThread, pairs, thread + 1 };
+            }
+            size_t journalBytes = journal.bytes;
+            double start = seconds();
+            runParallel(transferWorkerRun, workers, sizeof(TransferWorker), threads);
+            double elapsed = seconds() - start;
+            rates[pairs] = (double) (threads * perThread) / elapsed;
+            bytes[pairs] = (journal.bytes - journalBytes) / (threads * perThread);
+        }
+        printf("  journaled, %2zu threads  T record %8.0f transfers/s (%zu journal bytes)  W+D %8.0f transfers/s "
+               "(%zu journal bytes)\n", threads, rates[0], bytes[0], rates[1], bytes[1]);
+    }
+
+    FILE *transfers = fopen("transfers.txt", "w");
+    FILE *pairs = fopen("pairs.txt", "w");
+    if (transfers == NULL || pairs == NULL) {
+        perror("Error creating file. Function main()");
+        return EXIT_FAILURE;
+    }
+    unsigned long long seed = 1;
+    for (size_t i = 0; i < batchTransfers; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t row = (size_t) (seed >> 33) % accounts;
+        size_t toRow = (row + 1 + (size_t) (seed >> 13) % (accounts - 1)) % accounts;
+        fprintf(transfers, "T %d %d 0.01\n", table.accountNumbers[row], table.accountNumbers[toRow]);
+        fprintf(pairs, "W %d 0.01\nD %d 0.01\n", table.accountNumbers[row], table.accountNumbers[toRow]);
+    }
+    fclose(transfers);
+    fclose(pairs);
+
+    // Both batches start from the same balances
+    long long *balances = malloc(accounts * sizeof(long long));
+    if (balances == NULL) {
+        perror("Error allocating memory. Function main()");
+        return EXIT_FAILURE;
+    }
+    memcpy(balances, table.balances, accounts * sizeof(long long));
+    long long total = bankTotal(&table);
+    const char *files[2] = { "transfers.txt", "pairs.txt" };
+    double elapsed[2];
+    for (int i = 0; i < 2; i++) {
+        memcpy(table.balances, balances, accounts * sizeof(long long));
+        double start = seconds();
+        runBatch(&table, files[i], "results.txt");
+        elapsed[i] = seconds() - start;
+        // A pair whose withdrawal is refused still deposits, so only the T batch keeps the total
+        if (i == 0 && bankTotal(&table) != total) {
+            fprintf(stderr, "The transfer batch changed the total money in the bank\n");
+            return EXIT_FAILURE;
+        }
+    }
+    printf("  batch, %zu transfers    T lines %8.1f ms  W+D lines %8.1f ms\n", batchTransfers, elapsed[0] * 1000,
+           elapsed[1] * 1000);
+
+    journalClose();
+    const char *created[] = { JSON_FILE, JOURNAL_FILE, JOURNAL_OLD_FILE, "transfers.txt", "pairs.txt", "results.txt" };
+    for (size_t i = 0; i < sizeof(created) / sizeof(created[0]); i++) {
+        unlink(created[i]);
+    }
+    if (chdir("/") == 0) {
+        rmdir(directory);
+    }
+    free(balances);
+    indexFree();
+    tableFree(&table);
+    return EXIT_SUCCESS;
+}
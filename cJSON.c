@@ -49,6 +49,16 @@
 #include <locale.h>
 #endif
 
+/* SSE2 scanning in the parser on GCC/clang x86 builds, plus AVX2 selected at runtime on CPUs that have it */
+#if defined(__GNUC__) && defined(__SSE2__)
+#define CJSON_SIMD_SSE2
+#include <emmintrin.h>
+#if defined(__x86_64__) || defined(__i386__)
+#define CJSON_SIMD_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
 #if defined(_MSC_VER)
 #pragma warning (pop)
 #endif
@@ -237,6 +247,167 @@ CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks)
     }
 }
 
+#if defined(__clang__) || (defined(__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
+#pragma GCC diagnostic push
+#endif
+#ifdef __GNUC__
+#pragma GCC diagnostic ignored "-Wcast-qual"
+#endif
+/* helper function to cast away const */
+static void* cast_away_const(const void* string)
+{
+    return (void*)string;
+}
+#if defined(__clang__) || (defined(__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
+#pragma GCC diagnostic pop
+#endif
+
+/* Interned object keys. The table stores the registered pointers themselves, so parsed items can share
+ * them (flagged cJSON_StringIsConst) instead of each carrying its own copy of the key. */
+typedef struct
+{
+    const char *key;
+    size_t length;
+    unsigned long hash;
+    unsigned int folded_hash; /* see hash_key_folded */
+} interned_key;
+
+typedef struct
+{
+    interned_key *entries;
+    size_t capacity; /* always a power of two */
+    size_t count;
+    size_t max_length;
+    cJSON_bool enabled;
+} intern_table;
+
+static intern_table global_interned_keys = { NULL, 0, 0, 0, false };
+
+/* FNV-1a */
+static unsigned long hash_key(const unsigned char *key, size_t length)
+{
+    unsigned long hash = 2166136261UL;
+    size_t i = 0;
+
+    for (i = 0; i < length; i++)
+    {
+        hash = (hash ^ key[i]) * 16777619UL;
+    }
+
+    return hash;
+}
+
+/* Case-folded FNV-1a of an object key, consistent with case_insensitive_strcmp, so it can be cached in
+ * cJSON.stringhash and compared before the keys themselves. Never 0, which marks a hash that is not known. */
+static unsigned int hash_key_folded(const unsigned char *key)
+{
+    unsigned int hash = 2166136261U;
+
+    for (; *key != '\0'; key++)
+    {
+        hash = (hash ^ (unsigned int)tolower(*key)) * 16777619U;
+    }
+
+    return (hash == 0) ? 1 : hash;
+}
+
+static const interned_key *intern_lookup(const unsigned char *key, size_t length)
+{
+    unsigned long hash = 0;
+    size_t mask = 0;
+    size_t i = 0;
+
+    if ((global_interned_keys.count == 0) || (length > global_interned_keys.max_length))
+    {
+        return NULL;
+    }
+
+    hash = hash_key(key, length);
+    mask = global_interned_keys.capacity - 1;
+    for (i = hash & mask; global_interned_keys.entries[i].key != NULL; i = (i + 1) & mask)
+    {
+        const interned_key *entry = &global_interned_keys.entries[i];
+        if ((entry->hash == hash) && (entry->length == length) && (memcmp(entry->key, key, length) == 0))
+        {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+CJSON_PUBLIC(const char *) cJSON_InternKey(const char *key)
+{
+    const interned_key *existing = NULL;
+    size_t length = 0;
+    size_t mask = 0;
+    size_t i = 0;
+
+    if (key == NULL)
+    {
+        return NULL;
+    }
+
+    length = strlen(key);
+    existing = intern_lookup((const unsigned char*)key, length);
+    if (existing != NULL)
+    {
+        return existing->key;
+    }
+
+    /* keep the table at most half full */
+    if ((global_interned_keys.count + 1) * 2 > global_interned_keys.capacity)
+    {
+        size_t capacity = (global_interned_keys.capacity == 0) ? 32 : global_interned_keys.capacity * 2;
+        interned_key *entries = (interned_key*)internal_malloc(capacity * sizeof(interned_key));
+        if (entries == NULL)
+        {
+            return NULL;
+        }
+        memset(entries, '\0', capacity * sizeof(interned_key));
+
+        for (i = 0; i < global_interned_keys.capacity; i++)
+        {
+            if (global_interned_keys.entries[i].key != NULL)
+            {
+                size_t slot = global_interned_keys.entries[i].hash & (capacity - 1);
+                while (entries[slot].key != NULL)
+                {
+                    slot = (slot + 1) & (capacity - 1);
+                }
+                entries[slot] = global_interned_keys.entries[i];
+            }
+        }
+        internal_free(global_interned_keys.entries);
+        global_interned_keys.entries = entries;
+        global_interned_keys.capacity = capacity;
+    }
+
+    mask = global_interned_keys.capacity - 1;
+    {
+        unsigned long hash = hash_key((const unsigned char*)key, length);
+        for (i = hash & mask; global_interned_keys.entries[i].key != NULL; i = (i + 1) & mask)
+        {
+        }
+        global_interned_keys.entries[i].key = key;
+        global_interned_keys.entries[i].length = length;
+        global_interned_keys.entries[i].hash = hash;
+        global_interned_keys.entries[i].folded_hash = hash_key_folded((const unsigned char*)key);
+    }
+    global_interned_keys.count++;
+    if (length > global_interned_keys.max_length)
+    {
+        global_interned_keys.max_length = length;
+    }
+
+    return key;
+}
+
+CJSON_PUBLIC(void) cJSON_SetKeyInterning(cJSON_bool enable)
+{
+    global_interned_keys.enabled = enable;
+}
+
 /* Internal constructor. */
 static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
 {
@@ -291,6 +462,8 @@ typedef struct
     size_t offset;
     size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
     internal_hooks hooks;
+    size_t parallel_parts; /* for cJSON_ParseWithLengthParallel, 0 otherwise */
+    cJSON_TaskRunner run_tasks;
 } parse_buffer;
 
 /* check if the given size is left to read in a given parse buffer (starting with 1) */
@@ -301,13 +474,133 @@ typedef struct
 /* get a pointer to the buffer at the position */
 #define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
 
+/* exact powers of ten, 1e22 is the largest one a double holds without rounding */
+static const double exact_powers_of_ten[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Parse "-?digits(.digits)?([eE][+-]?digits)?" without strtod when the result is exact:
+ * at most 15 significant digits (so the mantissa is an exact double) scaled by at most 1e22,
+ * which rounds once and therefore matches strtod (Clinger's fast path).
+ * Returns the number of bytes consumed, or 0 if the caller has to fall back to strtod. */
+static size_t parse_number_fast(const unsigned char *input, size_t length, double *number)
+{
+    size_t i = 0;
+    size_t digits = 0;
+    int exponent = 0;
+    int explicit_exponent = 0;
+    cJSON_bool negative = false;
+    cJSON_bool exponent_negative = false;
+    double mantissa = 0;
+
+    /* the strtod path only sees the first 63 bytes */
+    if (length > 63)
+    {
+        length = 63;
+    }
+
+    if ((i < length) && (input[i] == '-'))
+    {
+        negative = true;
+        i++;
+    }
+    if ((i == length) || (input[i] < '0') || (input[i] > '9'))
+    {
+        return 0;
+    }
+    for (; (i < length) && (input[i] >= '0') && (input[i] <= '9'); i++)
+    {
+        if ((digits > 0) || (input[i] != '0'))
+        {
+            if (++digits > 15)
+            {
+                return 0;
+            }
+            mantissa = (mantissa * 10) + (input[i] - '0');
+        }
+    }
+    if ((i < length) && (input[i] == '.'))
+    {
+        i++;
+        if ((i == length) || (input[i] < '0') || (input[i] > '9'))
+        {
+            return 0;
+        }
+        for (; (i < length) && (input[i] >= '0') && (input[i] <= '9'); i++)
+        {
+            if ((digits > 0) || (input[i] != '0'))
+            {
+                if (++digits > 15)
+                {
+                    return 0;
+                }
+                mantissa = (mantissa * 10) + (input[i] - '0');
+            }
+            exponent--;
+        }
+    }
+    if ((i < length) && ((input[i] == 'e') || (input[i] == 'E')))
+    {
+        i++;
+        if ((i < length) && ((input[i] == '+') || (input[i] == '-')))
+        {
+            exponent_negative = input[i] == '-';
+            i++;
+        }
+        if ((i == length) || (input[i] < '0') || (input[i] > '9'))
+        {
+            return 0;
+        }
+        for (; (i < length) && (input[i] >= '0') && (input[i] <= '9'); i++)
+        {
+            if (explicit_exponent > 1000)
+            {
+                return 0;
+            }
+            explicit_exponent = (explicit_exponent * 10) + (input[i] - '0');
+        }
+        exponent += exponent_negative ? -explicit_exponent : explicit_exponent;
+    }
+    /* strtod would have seen the truncated copy */
+    if (i == 63)
+    {
+        return 0;
+    }
+
+    if ((mantissa != 0) && (exponent != 0))
+    {
+#if defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD == 0)
+        if ((exponent < -22) || (exponent > 22))
+        {
+            return 0;
+        }
+        if (exponent < 0)
+        {
+            mantissa /= exact_powers_of_ten[-exponent];
+        }
+        else
+        {
+            mantissa *= exact_powers_of_ten[exponent];
+        }
+#else
+        /* extended precision intermediates would round twice */
+        return 0;
+#endif
+    }
+
+    *number = negative ? -mantissa : mantissa;
+    return i;
+}
+
 /* Parse the input text to generate a number, and populate the result into item. */
 static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
 {
     double number = 0;
     unsigned char *after_end = NULL;
     unsigned char number_c_string[64];
-    unsigned char decimal_point = get_decimal_point();
+    unsigned char decimal_point = 0;
     size_t i = 0;
 
     if ((input_buffer == NULL) || (input_buffer->content == NULL))
@@ -315,6 +608,15 @@ static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_bu
         return false;
     }
 
+    i = parse_number_fast(buffer_at_offset(input_buffer), input_buffer->length - input_buffer->offset, &number);
+    if (i != 0)
+    {
+        input_buffer->offset += i;
+        goto number_end;
+    }
+
+    decimal_point = get_decimal_point();
+
     /* copy the number into a temporary buffer and replace '.' with the decimal point
      * of the current locale (for strtod)
      * This also takes care of '\0' not necessarily being available for marking the end of the input */
@@ -355,7 +657,9 @@ static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_bu
     {
         return false; /* parse_error */
     }
+    input_buffer->offset += (size_t)(after_end - number_c_string);
 
+    number_end:
     item->valuedouble = number;
 
     /* use saturation in case of overflow */
@@ -374,7 +678,6 @@ static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_bu
 
     item->type = cJSON_Number;
 
-    input_buffer->offset += (size_t)(after_end - number_c_string);
     return true;
 }
 
@@ -541,6 +844,120 @@ static cJSON_bool compare_double(double a, double b)
     return (fabs(a - b) <= maxVal * DBL_EPSILON);
 }
 
+/* write the decimal digits of an integral value below 1e15, returns the number of digits */
+static size_t print_digits(unsigned char *buffer, double value)
+{
+    unsigned char digits[16];
+    unsigned long high = (unsigned long)(value / 1e8);
+    unsigned long low = (unsigned long)(value - ((double)high * 1e8));
+    size_t length = 0;
+    size_t i = 0;
+
+    if (high != 0)
+    {
+        /* the low half keeps its leading zeros */
+        for (i = 0; i < 8; i++)
+        {
+            digits[length++] = (unsigned char)('0' + (low % 10));
+            low /= 10;
+        }
+        low = high;
+    }
+    do
+    {
+        digits[length++] = (unsigned char)('0' + (low % 10));
+        low /= 10;
+    } while (low != 0);
+
+    for (i = 0; i < length; i++)
+    {
+        buffer[i] = digits[length - i - 1];
+    }
+
+    return length;
+}
+
+/* Print d as the shortest m / 10^k that converts back to exactly d, for 1e-4 <= |d| < 1e15 and m < 1e15.
+ * Such an m has at most 15 digits and d is within half an ulp of it, so "%1.15g" prints the same
+ * digits in fixed notation and its round trip check passes; the output is identical to the sprintf path.
+ * Returns the length written (at most 22 bytes), or 0 if d needs the sprintf path. */
+static size_t print_short_decimal(unsigned char *buffer, double d)
+{
+#if defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD == 0)
+    unsigned char digits[16];
+    double magnitude = fabs(d);
+    double scaled = 0;
+    size_t digit_count = 0;
+    size_t length = 0;
+    size_t k = 0;
+
+    if ((magnitude < 1e-4) || (magnitude >= 1e15))
+    {
+        return 0;
+    }
+
+    for (k = 0; ; k++)
+    {
+        /* k stops at 19 here since magnitude >= 1e-4 */
+        if ((magnitude * exact_powers_of_ten[k]) >= 1e15)
+        {
+            return 0;
+        }
+        /* m and 10^k are exact, so the division rounds once and the comparison is exact */
+        scaled = floor((magnitude * exact_powers_of_ten[k]) + 0.5);
+        if ((scaled / exact_powers_of_ten[k]) == magnitude)
+        {
+            break;
+        }
+    }
+
+    digit_count = print_digits(digits, scaled);
+    if (d < 0)
+    {
+        buffer[length++] = '-';
+    }
+    if (digit_count <= k)
+    {
+        /* 0.000ddd */
+        buffer[length++] = '0';
+        buffer[length++] = '.';
+        memset(buffer + length, '0', k - digit_count);
+        length += k - digit_count;
+        memcpy(buffer + length, digits, digit_count);
+        return length + digit_count;
+    }
+
+    memcpy(buffer + length, digits, digit_count - k);
+    length += digit_count - k;
+    if (k > 0)
+    {
+        buffer[length++] = '.';
+        memcpy(buffer + length, digits + digit_count - k, k);
+        length += k;
+    }
+    return length;
+#else
+    (void)buffer;
+    (void)d;
+    return 0;
+#endif
+}
+
+/* print an int like "%d" */
+static size_t print_int(unsigned char *buffer, int value)
+{
+    size_t length = 0;
+
+    if (value < 0)
+    {
+        buffer[length++] = '-';
+        /* -(value + 1) + 1 stays in range for INT_MIN */
+        return length + print_digits(buffer + length, (double)(-(value + 1)) + 1);
+    }
+
+    return print_digits(buffer, (double)value);
+}
+
 /* Render the number nicely from the given item into a string. */
 static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
 {
@@ -564,9 +981,9 @@ static cJSON_bool print_number(const cJSON * const item, printbuffer * const out
     }
     else if(d == (double)item->valueint)
     {
-        length = sprintf((char*)number_buffer, "%d", item->valueint);
+        length = (int)print_int(number_buffer, item->valueint);
     }
-    else
+    else if ((length = (int)print_short_decimal(number_buffer, d)) == 0)
     {
         /* Try 15 decimal places of precision to avoid nonsignificant nonzero digits */
         length = sprintf((char*)number_buffer, "%1.15g", d);
@@ -740,33 +1157,190 @@ static unsigned char utf16_literal_to_utf8(const unsigned char * const input_poi
     }
     else
     {
-        /* invalid unicode codepoint */
-        goto fail;
+        /* invalid unicode codepoint */
+        goto fail;
+    }
+
+    /* encode as utf8 */
+    for (utf8_position = (unsigned char)(utf8_length - 1); utf8_position > 0; utf8_position--)
+    {
+        /* 10xxxxxx */
+        (*output_pointer)[utf8_position] = (unsigned char)((codepoint | 0x80) & 0xBF);
+        codepoint >>= 6;
+    }
+    /* encode first byte */
+    if (utf8_length > 1)
+    {
+        (*output_pointer)[0] = (unsigned char)((codepoint | first_byte_mark) & 0xFF);
+    }
+    else
+    {
+        (*output_pointer)[0] = (unsigned char)(codepoint & 0x7F);
+    }
+
+    *output_pointer += utf8_length;
+
+    return sequence_length;
+
+    fail:
+    return 0;
+}
+
+/* Byte scanners for the parser. count_whitespace returns the number of leading bytes <= 32 (what cJSON treats as
+ * whitespace), count_string_bytes the number of leading bytes that are neither a quote nor a backslash. */
+static size_t count_whitespace_scalar(const unsigned char *input, size_t length)
+{
+    size_t i = 0;
+    while ((i < length) && (input[i] <= 32))
+    {
+        i++;
+    }
+    return i;
+}
+
+static size_t count_string_bytes_scalar(const unsigned char *input, size_t length)
+{
+    size_t i = 0;
+    while ((i < length) && (input[i] != '\"') && (input[i] != '\\'))
+    {
+        i++;
+    }
+    return i;
+}
+
+#ifdef CJSON_SIMD_SSE2
+static size_t count_whitespace_sse2(const unsigned char *input, size_t length)
+{
+    const __m128i space = _mm_set1_epi8(32);
+    size_t i = 0;
+
+    for (; (i + 16) <= length; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)(input + i));
+        /* a byte is <= 32 exactly when max(byte, 32) == 32 */
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(chunk, space), space)) ^ 0xFFFFU;
+        if (mask != 0)
+        {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return i + count_whitespace_scalar(input + i, length - i);
+}
+
+static size_t count_string_bytes_sse2(const unsigned char *input, size_t length)
+{
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    size_t i = 0;
+
+    for (; (i + 16) <= length; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)(input + i));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+        if (mask != 0)
+        {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return i + count_string_bytes_scalar(input + i, length - i);
+}
+#endif
+
+#ifdef CJSON_SIMD_AVX2
+__attribute__((target("avx2")))
+static size_t count_whitespace_avx2(const unsigned char *input, size_t length)
+{
+    const __m256i space = _mm256_set1_epi8(32);
+    size_t i = 0;
+
+    for (; (i + 32) <= length; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)(input + i));
+        unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(chunk, space), space));
+        if (mask != 0)
+        {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return i + count_whitespace_scalar(input + i, length - i);
+}
+
+__attribute__((target("avx2")))
+static size_t count_string_bytes_avx2(const unsigned char *input, size_t length)
+{
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    size_t i = 0;
+
+    for (; (i + 32) <= length; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)(input + i));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)));
+        if (mask != 0)
+        {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return i + count_string_bytes_scalar(input + i, length - i);
+}
+
+/* -1 until the first scan checks the CPU; every thread computes the same answer, so the race is harmless */
+static int cpu_has_avx2 = -1;
+
+static cJSON_bool use_avx2(void)
+{
+    if (cpu_has_avx2 < 0)
+    {
+        cpu_has_avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
     }
+    return cpu_has_avx2 == 1;
+}
+#endif
 
-    /* encode as utf8 */
-    for (utf8_position = (unsigned char)(utf8_length - 1); utf8_position > 0; utf8_position--)
+static size_t count_whitespace(const unsigned char *input, size_t length)
+{
+    /* most runs are a newline and a few tabs, which a plain loop handles faster than a vector load */
+    size_t i = 0;
+    while ((i < length) && (i < 16) && (input[i] <= 32))
     {
-        /* 10xxxxxx */
-        (*output_pointer)[utf8_position] = (unsigned char)((codepoint | 0x80) & 0xBF);
-        codepoint >>= 6;
+        i++;
     }
-    /* encode first byte */
-    if (utf8_length > 1)
+    if ((i < 16) || (i == length))
     {
-        (*output_pointer)[0] = (unsigned char)((codepoint | first_byte_mark) & 0xFF);
+        return i;
     }
-    else
+    input += i;
+    length -= i;
+#ifdef CJSON_SIMD_AVX2
+    if (use_avx2())
     {
-        (*output_pointer)[0] = (unsigned char)(codepoint & 0x7F);
+        return i + count_whitespace_avx2(input, length);
     }
+#endif
+#ifdef CJSON_SIMD_SSE2
+    return i + count_whitespace_sse2(input, length);
+#else
+    return i + count_whitespace_scalar(input, length);
+#endif
+}
 
-    *output_pointer += utf8_length;
-
-    return sequence_length;
-
-    fail:
-    return 0;
+static size_t count_string_bytes(const unsigned char *input, size_t length)
+{
+#ifdef CJSON_SIMD_AVX2
+    if (use_avx2())
+    {
+        return count_string_bytes_avx2(input, length);
+    }
+#endif
+#ifdef CJSON_SIMD_SSE2
+    return count_string_bytes_sse2(input, length);
+#else
+    return count_string_bytes_scalar(input, length);
+#endif
 }
 
 /* Parse the input text into an unescaped cinput, and populate item. */
@@ -776,6 +1350,7 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     const unsigned char *input_end = buffer_at_offset(input_buffer) + 1;
     unsigned char *output_pointer = NULL;
     unsigned char *output = NULL;
+    cJSON_bool has_escapes = false;
 
     /* not a string */
     if (buffer_at_offset(input_buffer)[0] != '\"')
@@ -787,6 +1362,8 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
         /* calculate approximate size of the output (overestimate) */
         size_t allocation_length = 0;
         size_t skipped_bytes = 0;
+        /* jump straight to the next quote or backslash */
+        input_end += count_string_bytes(input_end, input_buffer->length - (size_t)(input_end - input_buffer->content));
         while (((size_t)(input_end - input_buffer->content) < input_buffer->length) && (*input_end != '\"'))
         {
             /* is escape sequence */
@@ -801,6 +1378,10 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
                 input_end++;
             }
             input_end++;
+            if ((size_t)(input_end - input_buffer->content) < input_buffer->length)
+            {
+                input_end += count_string_bytes(input_end, input_buffer->length - (size_t)(input_end - input_buffer->content));
+            }
         }
         if (((size_t)(input_end - input_buffer->content) >= input_buffer->length) || (*input_end != '\"'))
         {
@@ -809,6 +1390,7 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
 
         /* This is at most how much we need for the output */
         allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
+        has_escapes = skipped_bytes != 0;
         output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
         if (output == NULL)
         {
@@ -817,12 +1399,22 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     }
 
     output_pointer = output;
+    if (!has_escapes)
+    {
+        memcpy(output_pointer, input_pointer, (size_t)(input_end - input_pointer));
+        output_pointer += input_end - input_pointer;
+        input_pointer = input_end;
+    }
     /* loop through the string literal */
     while (input_pointer < input_end)
     {
         if (*input_pointer != '\\')
         {
-            *output_pointer++ = *input_pointer++;
+            /* copy everything up to the next escape (or the end) in one go */
+            size_t run_length = count_string_bytes(input_pointer, (size_t)(input_end - input_pointer));
+            memcpy(output_pointer, input_pointer, run_length);
+            output_pointer += run_length;
+            input_pointer += run_length;
         }
             /* escape sequence */
         else
@@ -1030,10 +1622,57 @@ static cJSON_bool print_string(const cJSON * const item, printbuffer * const p)
 static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer);
 static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer);
 static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool parse_array_parallel(parse_buffer * const input_buffer, cJSON **head, cJSON **tail);
 static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer);
 static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer);
 static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer);
 
+/* Parse an object key that is in the intern table without allocating: the item points at the interned key.
+ * Returns false (consuming nothing) if interning is off, the key is not interned or it contains escapes. */
+static cJSON_bool parse_interned_key(cJSON * const item, parse_buffer * const input_buffer)
+{
+    const unsigned char *start = NULL;
+    const unsigned char *end = NULL;
+    const unsigned char *limit = NULL;
+    const interned_key *key = NULL;
+
+    if (!global_interned_keys.enabled || cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '\"'))
+    {
+        return false;
+    }
+
+    start = buffer_at_offset(input_buffer) + 1;
+    limit = input_buffer->content + input_buffer->length;
+    if ((size_t)(limit - start) > global_interned_keys.max_length + 1)
+    {
+        limit = start + global_interned_keys.max_length + 1;
+    }
+    for (end = start; (end < limit) && (*end != '\"'); end++)
+    {
+        if (*end == '\\')
+        {
+            return false;
+        }
+    }
+    if ((end >= limit) || (*end != '\"'))
+    {
+        return false;
+    }
+
+    key = intern_lookup(start, (size_t)(end - start));
+    if (key == NULL)
+    {
+        return false;
+    }
+
+    item->string = (char*)cast_away_const(key->key);
+    item->stringhash = key->folded_hash;
+    item->type |= cJSON_StringIsConst;
+    input_buffer->offset = (size_t)(end + 1 - input_buffer->content);
+
+    return true;
+}
+
 /* Utility to jump whitespace and cr/lf */
 static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
 {
@@ -1047,10 +1686,7 @@ static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
         return buffer;
     }
 
-    while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32))
-    {
-        buffer->offset++;
-    }
+    buffer->offset += count_whitespace(buffer_at_offset(buffer), buffer->length - buffer->offset);
 
     if (buffer->offset == buffer->length)
     {
@@ -1091,10 +1727,9 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return
     return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
 }
 
-/* Parse an object - create a new root, and populate. */
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+static cJSON *parse_with_length(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, size_t parallel_parts, cJSON_TaskRunner run_tasks)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 }, 0, 0 };
     cJSON *item = NULL;
 
     /* reset error position */
@@ -1110,6 +1745,8 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
     buffer.length = buffer_length;
     buffer.offset = 0;
     buffer.hooks = global_hooks;
+    buffer.parallel_parts = (run_tasks != NULL) ? parallel_parts : 0;
+    buffer.run_tasks = run_tasks;
 
     item = cJSON_New_Item(&global_hooks);
     if (item == NULL) /* memory fail */
@@ -1171,6 +1808,12 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
     return NULL;
 }
 
+/* Parse an object - create a new root, and populate. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse_with_length(value, buffer_length, return_parse_end, require_null_terminated, 0, NULL);
+}
+
 /* Default options for cJSON_Parse */
 CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
 {
@@ -1182,6 +1825,11 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_len
     return cJSON_ParseWithLengthOpts(value, buffer_length, 0, 0);
 }
 
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthParallel(const char *value, size_t buffer_length, size_t parts, cJSON_TaskRunner run_tasks)
+{
+    return parse_with_length(value, buffer_length, 0, 0, parts, run_tasks);
+}
+
 #define cjson_min(a, b) (((a) < (b)) ? (a) : (b))
 
 static unsigned char *print(const cJSON * const item, cJSON_bool format, const internal_hooks * const hooks)
@@ -1308,6 +1956,51 @@ CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, cons
     return print_value(item, &p);
 }
 
+CJSON_PUBLIC(size_t) cJSON_PrintNumberValue(double number, char *buffer, size_t length)
+{
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    cJSON item;
+
+    if ((buffer == NULL) || (length == 0))
+    {
+        return 0;
+    }
+
+    memset(&item, 0, sizeof(item));
+    item.type = cJSON_Number;
+    cJSON_SetNumberHelper(&item, number);
+
+    p.buffer = (unsigned char*)buffer;
+    p.length = length;
+    p.noalloc = true;
+    p.hooks = global_hooks;
+
+    return print_number(&item, &p) ? p.offset : 0;
+}
+
+CJSON_PUBLIC(size_t) cJSON_PrintStringValue(const char *string, char *buffer, size_t length)
+{
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+
+    if ((buffer == NULL) || (length == 0))
+    {
+        return 0;
+    }
+
+    p.buffer = (unsigned char*)buffer;
+    p.length = length;
+    p.noalloc = true;
+    p.hooks = global_hooks;
+
+    if (!print_string_ptr((const unsigned char*)string, &p))
+    {
+        return 0;
+    }
+    update_offset(&p);
+
+    return p.offset;
+}
+
 /* Parser core - when encountering text, process appropriately. */
 static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer)
 {
@@ -1437,6 +2130,256 @@ static cJSON_bool print_value(const cJSON * const item, printbuffer * const outp
     }
 }
 
+/* Splitting a large array across threads for cJSON_ParseWithLengthParallel. */
+/* Minimum bytes of array per thread, and the spacing of candidate split points. */
+#define PARALLEL_PARSE_MIN_BYTES (256 * 1024)
+#define PARALLEL_PARSE_MARK_BYTES (64 * 1024)
+
+typedef struct
+{
+    parse_buffer buffer; /* starts at the first element of the range */
+    size_t end; /* offset of the ',' or ']' after the last element */
+    cJSON *head;
+    cJSON *tail;
+    cJSON_bool failed;
+} parse_array_range;
+
+/* Parse the elements of one range into its own list. */
+static void *parse_array_range_task(void *argument)
+{
+    parse_array_range *range = (parse_array_range*)argument;
+    parse_buffer *input_buffer = &range->buffer;
+
+    for (;;)
+    {
+        cJSON *new_item = NULL;
+
+        buffer_skip_whitespace(input_buffer);
+        new_item = cJSON_New_Item(&(input_buffer->hooks));
+        if (new_item == NULL)
+        {
+            break;
+        }
+        if (range->head == NULL)
+        {
+            range->head = new_item;
+        }
+        else
+        {
+            range->tail->next = new_item;
+            new_item->prev = range->tail;
+        }
+        range->tail = new_item;
+
+        if (!parse_value(new_item, input_buffer))
+        {
+            break;
+        }
+        buffer_skip_whitespace(input_buffer);
+        if (input_buffer->offset == range->end)
+        {
+            return NULL;
+        }
+        if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ','))
+        {
+            break;
+        }
+        input_buffer->offset++;
+    }
+
+    range->failed = true;
+    return NULL;
+}
+
+/* Find the top level commas of the array whose first element starts at start, and the closing bracket.
+ * Every comma that follows a PARALLEL_PARSE_MARK_BYTES boundary is kept as a candidate split point.
+ * Returns false if the input ends first or the brackets don't match, so the sequential parser can report the error. */
+static cJSON_bool scan_array(const parse_buffer * const input_buffer, size_t start, size_t **marks, size_t *mark_count, size_t *close)
+{
+    const unsigned char *content = input_buffer->content;
+    size_t length = input_buffer->length;
+    size_t position = start;
+    size_t depth = 0;
+    size_t next_mark = start + PARALLEL_PARSE_MARK_BYTES;
+    size_t capacity = 0;
+
+    *marks = NULL;
+    *mark_count = 0;
+    for (; position < length; position++)
+    {
+        switch (content[position])
+        {
+            case '\"':
+                /* jump over string bodies with the vectorized scanner used by parse_string */
+                position++;
+                for (;;)
+                {
+                    position += count_string_bytes(content + position, length - position);
+                    if (position >= length)
+                    {
+                        return false;
+                    }
+                    if (content[position] == '\"')
+                    {
+                        break;
+                    }
+                    position += 2; /* backslash and the escaped character */
+                }
+                break;
+
+            case '[':
+            case '{':
+                depth++;
+                break;
+
+            case ']':
+            case '}':
+                if (depth == 0)
+                {
+                    *close = position;
+                    return content[position] == ']';
+                }
+                depth--;
+                break;
+
+            case ',':
+                if ((depth == 0) && (position >= next_mark))
+                {
+                    if (*mark_count == capacity)
+                    {
+                        size_t *grown = NULL;
+                        capacity = (capacity == 0) ? 64 : capacity * 2;
+                        grown = (size_t*)input_buffer->hooks.allocate(capacity * sizeof(size_t));
+                        if (grown == NULL)
+                        {
+                            return false;
+                        }
+                        if (*marks != NULL)
+                        {
+                            memcpy(grown, *marks, *mark_count * sizeof(size_t));
+                            input_buffer->hooks.deallocate(*marks);
+                        }
+                        *marks = grown;
+                    }
+                    (*marks)[(*mark_count)++] = position;
+                    next_mark = position + PARALLEL_PARSE_MARK_BYTES;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return false;
+}
+
+/* Parse the elements of the array at input_buffer (positioned on the first element) in parallel ranges.
+ * On success the elements are linked into *head..*tail and the buffer is at the closing bracket.
+ * Returns false without consuming input if the array is too small, malformed or a range fails,
+ * so the caller parses it sequentially (and reports errors at the usual position). */
+static cJSON_bool parse_array_parallel(parse_buffer * const input_buffer, cJSON **head, cJSON **tail)
+{
+    parse_array_range *ranges = NULL;
+    size_t *marks = NULL;
+    size_t mark_count = 0;
+    size_t close = 0;
+    size_t parts = input_buffer->parallel_parts;
+    size_t range_count = 0;
+    size_t start = input_buffer->offset;
+    size_t next_mark = 0;
+    size_t i = 0;
+    cJSON_bool parsed = false;
+
+    if (!scan_array(input_buffer, start, &marks, &mark_count, &close))
+    {
+        goto cleanup;
+    }
+    if (parts > ((close - start) / PARALLEL_PARSE_MIN_BYTES))
+    {
+        parts = (close - start) / PARALLEL_PARSE_MIN_BYTES;
+    }
+    if ((parts < 2) || (mark_count == 0))
+    {
+        goto cleanup;
+    }
+
+    ranges = (parse_array_range*)input_buffer->hooks.allocate(parts * sizeof(parse_array_range));
+    if (ranges == NULL)
+    {
+        goto cleanup;
+    }
+
+    /* range i ends at the first candidate comma at or past i/parts of the array */
+    for (i = 0; i < parts; i++)
+    {
+        size_t target = start + ((close - start) / parts) * (i + 1);
+        parse_array_range *range = &ranges[range_count];
+
+        while ((next_mark < mark_count) && (marks[next_mark] < target) && (i + 1 < parts))
+        {
+            next_mark++;
+        }
+        if ((i + 1 < parts) && (next_mark == mark_count))
+        {
+            continue;
+        }
+
+        range->buffer = *input_buffer;
+        range->buffer.offset = (range_count == 0) ? start : (ranges[range_count - 1].end + 1);
+        range->buffer.parallel_parts = 0; /* nested arrays are parsed sequentially */
+        range->end = (i + 1 < parts) ? marks[next_mark++] : close;
+        range->head = NULL;
+        range->tail = NULL;
+        range->failed = false;
+        range_count++;
+    }
+
+    input_buffer->run_tasks(parse_array_range_task, ranges, sizeof(parse_array_range), range_count);
+
+    parsed = true;
+    for (i = 0; i < range_count; i++)
+    {
+        if (ranges[i].failed)
+        {
+            parsed = false;
+        }
+    }
+    if (!parsed)
+    {
+        for (i = 0; i < range_count; i++)
+        {
+            if (ranges[i].head != NULL)
+            {
+                cJSON_Delete(ranges[i].head);
+            }
+        }
+        goto cleanup;
+    }
+
+    /* splice the ranges in order */
+    *head = ranges[0].head;
+    for (i = 1; i < range_count; i++)
+    {
+        ranges[i - 1].tail->next = ranges[i].head;
+        ranges[i].head->prev = ranges[i - 1].tail;
+    }
+    *tail = ranges[range_count - 1].tail;
+    input_buffer->offset = close;
+
+    cleanup:
+    if (ranges != NULL)
+    {
+        input_buffer->hooks.deallocate(ranges);
+    }
+    if (marks != NULL)
+    {
+        input_buffer->hooks.deallocate(marks);
+    }
+
+    return parsed;
+}
+
 /* Build an array from input text. */
 static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer)
 {
@@ -1470,6 +2413,13 @@ static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buf
         goto fail;
     }
 
+    /* big arrays near the root are split between threads; this consumes nothing if it doesn't apply */
+    if ((input_buffer->parallel_parts > 1) && (input_buffer->depth <= 2)
+        && parse_array_parallel(input_buffer, &head, &current_item))
+    {
+        goto array_end;
+    }
+
     /* step back to character in front of the first element */
     input_buffer->offset--;
     /* loop through the comma separated array elements */
@@ -1507,6 +2457,7 @@ static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buf
     }
     while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
 
+    array_end:
     if (cannot_access_at_index(input_buffer, 0) || buffer_at_offset(input_buffer)[0] != ']')
     {
         goto fail; /* expected end of array */
@@ -1602,6 +2553,8 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
 {
     cJSON *head = NULL; /* linked list head */
     cJSON *current_item = NULL;
+    cJSON_bool key_is_interned = false;
+    cJSON_bool parsed_value = false;
 
     if (input_buffer->depth >= CJSON_NESTING_LIMIT)
     {
@@ -1657,16 +2610,21 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         /* parse the name of the child */
         input_buffer->offset++;
         buffer_skip_whitespace(input_buffer);
-        if (!parse_string(current_item, input_buffer))
+        key_is_interned = parse_interned_key(current_item, input_buffer);
+        if (!key_is_interned)
         {
-            goto fail; /* failed to parse name */
+            if (!parse_string(current_item, input_buffer))
+            {
+                goto fail; /* failed to parse name */
+            }
+
+            /* swap valuestring and string, because we parsed the name */
+            current_item->string = current_item->valuestring;
+            current_item->valuestring = NULL;
+            current_item->stringhash = hash_key_folded((const unsigned char*)current_item->string);
         }
         buffer_skip_whitespace(input_buffer);
 
-        /* swap valuestring and string, because we parsed the name */
-        current_item->string = current_item->valuestring;
-        current_item->valuestring = NULL;
-
         if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
         {
             goto fail; /* invalid object */
@@ -1675,7 +2633,13 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         /* parse the value */
         input_buffer->offset++;
         buffer_skip_whitespace(input_buffer);
-        if (!parse_value(current_item, input_buffer))
+        parsed_value = parse_value(current_item, input_buffer);
+        /* parse_value overwrites the type, so restore the flag that keeps cJSON_Delete off the interned key */
+        if (key_is_interned)
+        {
+            current_item->type |= cJSON_StringIsConst;
+        }
+        if (!parsed_value)
         {
             goto fail; /* failed to parse value */
         }
@@ -1877,9 +2841,37 @@ CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index)
     return get_array_item(array, (size_t)index);
 }
 
+/* Compare a key against a child's key, using the cached hashes to skip most mismatches without touching the strings.
+ * name_hash is computed on first use, so lookups of interned keys that match by pointer never hash at all. */
+static cJSON_bool object_key_matches(const cJSON * const element, const char * const name, unsigned int * const name_hash, const cJSON_bool case_sensitive)
+{
+    if (element->string == name)
+    {
+        return true;
+    }
+    if (element->stringhash != 0)
+    {
+        if (*name_hash == 0)
+        {
+            *name_hash = hash_key_folded((const unsigned char*)name);
+        }
+        if (element->stringhash != *name_hash)
+        {
+            return false;
+        }
+    }
+
+    if (case_sensitive)
+    {
+        return strcmp(name, element->string) == 0;
+    }
+    return case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)(element->string)) == 0;
+}
+
 static cJSON *get_object_item(const cJSON * const object, const char * const name, const cJSON_bool case_sensitive)
 {
     cJSON *current_element = NULL;
+    unsigned int name_hash = 0;
 
     if ((object == NULL) || (name == NULL))
     {
@@ -1889,14 +2881,14 @@ static cJSON *get_object_item(const cJSON * const object, const char * const nam
     current_element = object->child;
     if (case_sensitive)
     {
-        while ((current_element != NULL) && (current_element->string != NULL) && (strcmp(name, current_element->string) != 0))
+        while ((current_element != NULL) && (current_element->string != NULL) && !object_key_matches(current_element, name, &name_hash, true))
         {
             current_element = current_element->next;
         }
     }
     else
     {
-        while ((current_element != NULL) && (case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)(current_element->string)) != 0))
+        while ((current_element != NULL) && ((current_element->string == NULL) || !object_key_matches(current_element, name, &name_hash, false)))
         {
             current_element = current_element->next;
         }
@@ -1948,6 +2940,7 @@ static cJSON *create_reference(const cJSON *item, const internal_hooks * const h
 
     memcpy(reference, item, sizeof(cJSON));
     reference->string = NULL;
+    reference->stringhash = 0;
     reference->type |= cJSON_IsReference;
     reference->next = reference->prev = NULL;
     return reference;
@@ -1992,20 +2985,6 @@ CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToArray(cJSON *array, cJSON *item)
     return add_item_to_array(array, item);
 }
 
-#if defined(__clang__) || (defined(__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
-#pragma GCC diagnostic push
-#endif
-#ifdef __GNUC__
-#pragma GCC diagnostic ignored "-Wcast-qual"
-#endif
-/* helper function to cast away const */
-static void* cast_away_const(const void* string)
-{
-    return (void*)string;
-}
-#if defined(__clang__) || (defined(__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
-#pragma GCC diagnostic pop
-#endif
 
 
 static cJSON_bool add_item_to_object(cJSON * const object, const char * const string, cJSON * const item, const internal_hooks * const hooks, const cJSON_bool constant_key)
@@ -2040,6 +3019,7 @@ static cJSON_bool add_item_to_object(cJSON * const object, const char * const st
     }
 
     item->string = new_key;
+    item->stringhash = hash_key_folded((const unsigned char*)new_key);
     item->type = new_type;
 
     return add_item_to_array(object, item);
@@ -2365,6 +3345,7 @@ static cJSON_bool replace_item_in_object(cJSON *object, const char *string, cJSO
     {
         return false;
     }
+    replacement->stringhash = hash_key_folded((const unsigned char*)replacement->string);
 
     replacement->type &= ~cJSON_StringIsConst;
 
@@ -2736,6 +3717,7 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
     if (item->string)
     {
         newitem->string = (item->type&cJSON_StringIsConst) ? item->string : (char*)cJSON_strdup((unsigned char*)item->string, &global_hooks);
+        newitem->stringhash = item->stringhash;
         if (!newitem->string)
         {
             goto fail;
@@ -110,6 +110,8 @@ typedef struct cJSON
 
     /* The type of the item, as above. */
     int type;
+    /* Case-folded hash of string, maintained by cJSON to speed up GetObjectItem. 0 means unknown; reset it to 0 if you assign string yourself. */
+    unsigned int stringhash;
 
     /* The item's string, if type==cJSON_String  and type == cJSON_Raw */
     char *valuestring;
@@ -131,6 +133,10 @@ typedef struct cJSON_Hooks
 
 typedef int cJSON_bool;
 
+/* Runs task on each of the count elements of tasks (each task_size bytes apart), concurrently, and returns when all have finished.
+ * Supplied by the application so cJSON doesn't depend on a thread library. */
+typedef void (*cJSON_TaskRunner)(void *(*task)(void *), void *tasks, size_t task_size, size_t count);
+
 /* Limits how deeply nested arrays/objects can be before cJSON rejects to parse them.
  * This is to prevent stack overflows. */
 #ifndef CJSON_NESTING_LIMIT
@@ -143,10 +149,22 @@ CJSON_PUBLIC(const char*) cJSON_Version(void);
 /* Supply malloc, realloc and free functions to cJSON */
 CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks);
 
+/* Register an object key in the shared intern table and return the interned pointer (an earlier registration of
+ * the same key wins). The table keeps the pointer itself, so the string must stay valid for as long as any parsed
+ * item may use it, e.g. a string literal. Registration is not thread safe; lookups during parsing are. */
+CJSON_PUBLIC(const char *) cJSON_InternKey(const char *key);
+/* When enabled, the parser points object keys that are in the intern table at the interned string (flagged
+ * cJSON_StringIsConst) instead of allocating a copy per item. Disabled by default. */
+CJSON_PUBLIC(void) cJSON_SetKeyInterning(cJSON_bool enable);
+
 /* Memory Management: the caller is always responsible to free the results from all variants of cJSON_Parse (with cJSON_Delete) and cJSON_Print (with stdlib free, cJSON_Hooks.free_fn, or cJSON_free as appropriate). The exception is cJSON_PrintPreallocated, where the caller has full responsibility of the buffer. */
 /* Supply a block of JSON, and this returns a cJSON object you can interrogate. */
 CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value);
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_length);
+/* Like cJSON_ParseWithLength, but a large array at the root or directly inside the root object is pre-scanned for element
+ * boundaries and split into at most parts ranges that run_tasks parses concurrently. The result is the same as a sequential
+ * parse. The allocator set with cJSON_InitHooks is called from those threads, so it has to be thread-safe. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthParallel(const char *value, size_t buffer_length, size_t parts, cJSON_TaskRunner run_tasks);
 /* ParseWithOpts allows you to require (and check) that the JSON is null terminated, and to retrieve the pointer to the final byte parsed. */
 /* If you supply a ptr in return_parse_end and parsing fails, then return_parse_end will contain a pointer to the error so will match cJSON_GetErrorPtr(). */
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
@@ -161,6 +179,11 @@ CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON
 /* Render a cJSON entity to text using a buffer already allocated in memory with given length. Returns 1 on success and 0 on failure. */
 /* NOTE: cJSON is not always 100% accurate in estimating how much memory it will use, so to be safe allocate 5 bytes more than you actually need */
 CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format);
+/* Print a number or a string (quoted and escaped) into buffer exactly as cJSON_Print prints such a value, for code that
+ * writes JSON for a fixed schema itself. Returns the length written (a terminator follows it), or 0 if length is too small:
+ * a number needs at most 26 bytes, a string at most 6 per input byte plus 3. */
+CJSON_PUBLIC(size_t) cJSON_PrintNumberValue(double number, char *buffer, size_t length);
+CJSON_PUBLIC(size_t) cJSON_PrintStringValue(const char *string, char *buffer, size_t length);
 /* Delete a cJSON entity and all subentities. */
 CJSON_PUBLIC(void) cJSON_Delete(cJSON *item);
 
@@ -12,9 +12,10 @@
     6. Logout
     7. View details
     8. Delete account
+    9. Transfer to another account
 
     Security features:
-    1. Account number is randomly generated
+    1. Account number is randomly generated from a seeded generator
     2. Account number is unique
     3. Pin is required to withdraw money > 1000
     4. Pin is required to change pin
@@ -32,13 +33,31 @@
     8. changePin() - Changes the pin of the user's account
     9. viewDetails() - Displays the details of the user's account
     10. deleteAccount() - Deletes the user's account
-    11. saveToFile() - Saves the JSON object to a file
-    12. loadFromFile() - Loads the JSON object from a file
+    11. saveToFile() - Streams the account table into a snapshot file in fixed-size chunks
+    12. loadFromFile() - Loads the account table from a file
+    13. indexBuild() - Builds the account number index from the account table
+    14. indexFind() - Finds an account by account number in O(1)
+    15. journalReplay() - Replays the transaction journal on top of the loaded snapshot
+    16. checkpoint() - Saves a snapshot from a forked copy-on-write child and discards the journal records it covers
+    17. checkpointerRun() - Background thread that checkpoints on journal size or elapsed time
+    18. journalFlusherRun() - Background thread that group-commits journal records with one fsync per batch
+    19. reserveAccountNumbers() - Reserves a block of unused account numbers, e.g. for the creations of a batch
+    20. poolMalloc()/poolFree() - Slab allocator for cJSON nodes and strings, installed with cJSON_InitHooks
+    21. internKeys() - Registers the account field names so every account shares one copy of each key
+    22. parseAccountLines() - Loads a JSON Lines snapshot (--format=jsonl), parsing newline-split chunks on all cores
+    23. runParallel() - Runs an array of independent tasks on one thread each
+    24. decodeAccountDocument()/decodeAccountLines() - Schema decoder from a snapshot straight into the account table
+    25. encodeAccounts() - Schema encoder that writes accounts with pre-escaped key fragments, on all cores
+    26. tableAdd()/tableRemove() - Column-per-field account table with a shared string heap, the live account set
+    27. parseAmount()/formatAmount() - Exact decimal amounts to and from whole cents
+    28. runBatch() - Applies a file of operations in one pass (--batch), writes per-operation results and saves once
+    29. transfer() - Moves money between two accounts as one atomic update and one journal record
+    30. batchWorkerRun() - Batch worker thread (--threads) taking operations from a shared queue under per-account locks
 
     Highlights:
     1. Uses cJSON library and JSON files to store data unlike traditional text files
-    2. Uses a random number generator to generate account numbers
-    4. Uses a function to check if an account number exists in the array
+    2. Uses a random number generator and a bitmap of used numbers to generate unique account numbers
+    4. Uses a hash index to find accounts and check if an account number exists in constant time
     5. User login is based on account number, not name
    */
 
@@ -48,6 +67,15 @@
 #include <string.h>
 #include "cJSON.c"
 #include <time.h>
+#include <math.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include "cJSON.h"
 
 
@@ -56,8 +84,80 @@
 #define MAX_PHONE_LENGTH 15
 #define MAX_PIN_LENGTH 6
 #define ACCOUNT_NUMBER_LENGTH 9
+#define ACCOUNT_NUMBER_MIN 10000000
+#define ACCOUNT_NUMBER_MAX 99999999
 #define JSON_FILE "accounts.json"
+#define JSON_TEMP_FILE JSON_FILE ".tmp"
+#define JOURNAL_FILE "accounts.journal"
+#define JOURNAL_OLD_FILE JOURNAL_FILE ".old"
+#define CHECKPOINT_JOURNAL_BYTES (4 * 1024 * 1024)
+#define CHECKPOINT_INTERVAL_SECONDS 300
+#define GROUP_COMMIT_WINDOW_MICROSECONDS 2000 // How long a batch waits for more records before its fsync
+#define GROUP_COMMIT_MAX_OPS 128 // A batch that reaches this many records is flushed at once
+#define POOL_CHUNK_SIZE (1024 * 1024)
+#define POOL_MAX_SIZE 256 // Larger allocations (print buffers, long strings) go straight to malloc
+#define POOL_CLASSES (POOL_MAX_SIZE / 8)
+#define SNAPSHOT_BUFFER_SIZE (64 * 1024)
+#define PARALLEL_MAX_THREADS 64
+#define PARALLEL_MIN_BYTES (1024 * 1024) // Smaller inputs are not worth a thread each
+#define ENCODE_RANGE_ACCOUNTS 4096
+#define TABLE_COMPACT_MIN_BYTES (1024 * 1024) // Garbage in the string heap below this is never worth a copy
+#define NO_ROW ((size_t) -1)
+#define MINOR_UNITS 100 // Money is held as a whole number of cents
+#define AMOUNT_LENGTH 32 // Enough for any amount as text, sign and terminator included
+#define BATCH_CLAIM_OPS 64 // Operations a batch worker takes from the queue at a time
+#define ACCOUNT_LOCK_STRIPES 4096
+#define JSONL_HEADER "{\"accountsFormat\":\"jsonl\"" // First bytes of a JSON Lines snapshot
+
+
+/* Field names of the JSON document. These exact pointers are interned, so parsed accounts, accounts built by
+   newAccount and the lookups below all share them and a matching key is found by pointer comparison. */
+const char KEY_ACCOUNTS[] = "accounts";
+const char KEY_JOURNAL_SEQ[] = "journalSeq";
+const char KEY_NAME[] = "name";
+const char KEY_COUNTRY[] = "country";
+const char KEY_STATE[] = "state";
+const char KEY_CITY[] = "city";
+const char KEY_STREET[] = "street";
+const char KEY_HOUSE_NUMBER[] = "houseNumber";
+const char KEY_PHONE[] = "phone";
+const char KEY_PIN[] = "pin";
+const char KEY_SECURITY_QUESTION[] = "securityQuestion";
+const char KEY_SECURITY_ANSWER[] = "securityAnswer";
+const char KEY_ACCOUNT_NUMBER[] = "accountNumber";
+const char KEY_BALANCE[] = "balance";
+
+// On-disk layout of the snapshot, chosen with --format. Loading detects the layout from the file itself.
+typedef enum {
+    FORMAT_PRETTY, // One indented document, the original layout
+    FORMAT_COMPACT, // The same document without whitespace
+    FORMAT_JSONL // A header line with journalSeq, then one compact account object per line
+} StorageFormat;
+
+StorageFormat storageFormat = FORMAT_PRETTY;
 
+/*
+   Batch mode, --batch=FILE --out=FILE. Applies a file of operations from upstream systems to the account table in
+   one pass without the menu, then saves one snapshot and writes one result line per operation. Batch operations are
+   not journaled, so a batch reaches disk whole with the snapshot or not at all, and results are only written once it
+   has. Batches are trusted input: no pins are asked for. One operation per line, fields separated by spaces:
+    D <accountNumber> <amount>                                 deposit
+    W <accountNumber> <amount>                                 withdrawal
+    P <accountNumber> <newPin>                                 pin change
+    T <accountNumber> <toAccountNumber> <amount>               transfer; the result shows the sending account
+    C <name> <country> <state> <city> <street> <houseNumber> <phone> <pin> <balance> <question>|<answer>
+                                                               account creation; question and answer may have spaces
+   Empty lines and lines starting with # are skipped. Each result line is one of
+    <lineNumber> OK <accountNumber> <balance>
+    <lineNumber> ERROR <reason>
+   With --threads=N the operations are shared out to N worker threads. Results still come out in line order, but
+   two operations on the same account may then be applied in either order.
+*/
+const char *batchFile = NULL;
+const char *batchOutFile = NULL;
+size_t batchThreads = 1;
+
+int verbose = 0; // --verbose: report checkpoint timings and journal batching on stderr
 
 typedef struct {
     char name[MAX_NAME_LENGTH];
@@ -69,38 +169,408 @@ typedef struct {
     char phone[MAX_PHONE_LENGTH];
     char pin[MAX_PIN_LENGTH];
     char accountNumber[ACCOUNT_NUMBER_LENGTH];
-    double balance;
+    long long balance; // In cents, like every amount
 } Account;
 
+/* One slot of the account index. Account numbers are never 0, so 0 marks an empty slot. */
+typedef struct {
+    int accountNumber;
+    size_t row;
+} IndexSlot;
+
+/* Open-addressing (linear probing) hash table from account number to the account's row in the account table */
+typedef struct {
+    IndexSlot *slots;
+    size_t capacity; // Always a power of two
+    size_t count;
+} AccountIndex;
+
+AccountIndex accountIndex;
+
+/*
+   One bit per account number in [ACCOUNT_NUMBER_MIN, ACCOUNT_NUMBER_MAX], kept in sync with the index.
+   Each bit of fullWords marks a word of usedBits that has no free number left, so finding a free number
+   never scans more than one summary word per 4096 taken numbers.
+*/
+typedef struct {
+    unsigned long long *usedBits;
+    unsigned long long *fullWords;
+    size_t used;
+    unsigned long long seed;
+} AccountNumbers;
+
+AccountNumbers accountNumbers;
+
+/*
+   Slab allocator behind cJSON. Blocks are carved out of POOL_CHUNK_SIZE chunks in 8-byte size classes,
+   each preceded by an 8-byte header holding its class, and freed blocks go on a per-class free list.
+   Bump pointers and free lists are per thread so allocation never takes a lock; chunks are registered
+   globally, so poolRelease() drops a whole document in one pass instead of walking it with cJSON_Delete.
+*/
+typedef struct PoolChunk {
+    struct PoolChunk *next;
+    size_t pad; // Keeps the blocks after the chunk header 16-byte aligned
+} PoolChunk;
+
+typedef struct {
+    pthread_mutex_t lock;
+    PoolChunk *chunks;
+    size_t chunkCount;
+    unsigned long generation; // Bumped by poolRelease() to invalidate every thread's cache
+} Pool;
+
+typedef struct {
+    unsigned long generation;
+    char *cursor;
+    char *end;
+    size_t *freeLists[POOL_CLASSES];
+} PoolCache;
+
+Pool pool = { PTHREAD_MUTEX_INITIALIZER, NULL, 0, 1 };
+__thread PoolCache poolCache;
+
+/*
+   Append-only journal of mutations made since the last snapshot. Every record is one line:
+    <seq> D <accountNumber> <amount> <newBalance>   deposit
+    <seq> W <accountNumber> <amount> <newBalance>   withdrawal
+    <seq> T <accountNumber> <toAccountNumber> <amount> <newBalance> <toNewBalance>   transfer
+    <seq> P <accountNumber> <newPin>                pin change
+    <seq> C <accountNumber> <account as compact JSON> account creation
+    <seq> X <accountNumber>                         account deletion
+   Amounts are written exactly, as formatAmount() prints them ("510.35").
+   The snapshot stores the sequence number of the last record it contains as "journalSeq".
+   A checkpoint renames the journal to JOURNAL_OLD_FILE and starts a new one; the old file is
+   removed once the snapshot covering it is on disk, so startup replays the old file, then the new one.
+
+   Records are group-committed: appends go to an in-memory batch, the flusher thread writes the batch and
+   fsyncs it once, and journalCommit() blocks a caller until the batch holding its record is durable.
+*/
+typedef struct {
+    int fd;
+    unsigned long long nextSeq;
+    size_t bytes; // Size of the live journal including unflushed records, used to trigger checkpoints
+
+    pthread_mutex_t lock; // Guards everything below; taken after bankMutex when both are needed
+    pthread_cond_t flushWake;
+    pthread_cond_t durable;
+    pthread_t flusher;
+    int stop;
+    int flushing; // The flusher is writing a batch outside the lock
+    char *pending;
+    size_t pendingLength;
+    size_t pendingCapacity;
+    size_t pendingOps;
+    unsigned long long pendingLastSeq;
+    struct timespec pendingSince;
+    unsigned long long durableSeq;
+    unsigned long long fsyncs;
+    unsigned long long committedOps;
+} Journal;
+
+Journal journal = {
+    .fd = -1,
+    .nextSeq = 1,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .flushWake = PTHREAD_COND_INITIALIZER,
+    .durable = PTHREAD_COND_INITIALIZER,
+};
+
+/* Schema decoder. Snapshots written by this program have a fixed shape: every account has the ten string fields
+   below followed by accountNumber and balance, in the order newAccount() creates them. The decoder reads that shape
+   straight into the account table without building a node per value or looking keys up by name. Anything else
+   (other keys, another order, hand-edited files) makes it give up, and the generic cJSON parser loads the file
+   instead. */
+typedef enum {
+    FIELD_NAME,
+    FIELD_COUNTRY,
+    FIELD_STATE,
+    FIELD_CITY,
+    FIELD_STREET,
+    FIELD_HOUSE_NUMBER,
+    FIELD_PHONE,
+    FIELD_PIN,
+    FIELD_SECURITY_QUESTION,
+    FIELD_SECURITY_ANSWER,
+    ACCOUNT_STRING_FIELDS
+} AccountField;
+
+const char *const ACCOUNT_STRING_KEYS[ACCOUNT_STRING_FIELDS] = {
+    KEY_NAME, KEY_COUNTRY, KEY_STATE, KEY_CITY, KEY_STREET, KEY_HOUSE_NUMBER, KEY_PHONE, KEY_PIN,
+    KEY_SECURITY_QUESTION, KEY_SECURITY_ANSWER
+};
+
+// Buffer sizes the menu reads each field into (login() copies the name into Account.name), terminator included
+const size_t ACCOUNT_STRING_SIZES[ACCOUNT_STRING_FIELDS] = {
+    MAX_NAME_LENGTH, MAX_ADDRESS_LENGTH, MAX_ADDRESS_LENGTH, MAX_ADDRESS_LENGTH, MAX_ADDRESS_LENGTH,
+    MAX_ADDRESS_LENGTH, MAX_PHONE_LENGTH, MAX_PIN_LENGTH, MAX_NAME_LENGTH, MAX_NAME_LENGTH
+};
+
+/*
+   The live account set, one column per field. Strings are kept NUL-terminated in one shared heap and the string
+   columns hold their offsets, so an account costs about a hundred bytes instead of a cJSON node per field.
+   cJSON is only used to read snapshots the decoder gives up on. Rows are not stable: deleting an account moves
+   the last row into its place and re-points the index at it.
+*/
+typedef struct {
+    size_t count;
+    size_t capacity;
+    int *accountNumbers;
+    long long *balances; // In cents
+    size_t *fields[ACCOUNT_STRING_FIELDS];
+    char *strings;
+    size_t stringsLength;
+    size_t stringsCapacity;
+    size_t stringsGarbage; // Bytes of replaced and deleted strings, reclaimed by tableCompact()
+    unsigned long long journalSeq; // Last journal record the snapshot contains
+} AccountTable;
+
+typedef struct {
+    const char *at;
+    const char *end;
+    AccountTable *out;
+} Decoder;
+
+/* Schema encoder, the counterpart of the decoder: writes the rows of the account table with the key text already
+   escaped and laid out for the pretty and compact layouts, printing only the values. The output is the same bytes
+   cJSON_Print/cJSON_PrintUnformatted produce for the equivalent document. */
+typedef struct {
+    char open[8];
+    char keys[ACCOUNT_STRING_FIELDS + 2][64]; // Everything before each value: separator, indentation, "key":
+    char close[8];
+    char separator[4]; // Between two accounts in the array
+    size_t openLength;
+    size_t keyLengths[ACCOUNT_STRING_FIELDS + 2];
+    size_t closeLength;
+    size_t separatorLength;
+} AccountLayout;
+
+AccountLayout accountLayouts[2]; // Compact, pretty
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} EncodeBuffer;
+
+// A run of consecutive accounts encoded on one thread
+typedef struct {
+    const AccountTable *table;
+    size_t first;
+    size_t count;
+    int pretty;
+    int lines; // JSON Lines: a newline after every account instead of separators
+    EncodeBuffer out;
+} EncodeRange;
+
+// A newline-aligned slice of a JSON Lines snapshot and the accounts parsed from it
+typedef struct {
+    const char *begin;
+    const char *end;
+    AccountTable rows;
+    int failed;
+} LineChunk;
+
+// Destination of a streamed snapshot. Small writes (one JSON Lines account) are collected before they hit the file.
+typedef struct {
+    int fd;
+    size_t bytes;
+    size_t used;
+    char buffer[SNAPSHOT_BUFFER_SIZE];
+} SnapshotWriter;
+
+typedef struct {
+    pthread_t thread;
+    pthread_cond_t wake;
+    int stop;
+    time_t lastCheckpoint;
+    AccountTable *table;
+} Checkpointer;
+
+Checkpointer checkpointer = { .wake = PTHREAD_COND_INITIALIZER };
+
+/* Guards the account table, the index and the journal between the menu thread and the checkpointer */
+pthread_mutex_t bankMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+   Batch workers run while nothing else touches the table, so they have their own locking. Balance changes hold
+   tableLock shared and the lock stripes of their accounts; a transfer takes its two stripes lowest first, so two
+   transfers can never deadlock. Anything that adds rows or strings (creations, pin changes) holds
+   tableLock exclusively, because it may move the columns or the string heap.
+*/
+typedef struct {
+    pthread_mutex_t lock;
+} __attribute__((aligned(64))) AccountLock; // One cache line each, so neighbouring stripes do not contend
+
+AccountLock accountLocks[ACCOUNT_LOCK_STRIPES];
+pthread_rwlock_t tableLock = PTHREAD_RWLOCK_INITIALIZER;
+
+typedef struct {
+    char *line;
+    size_t lineNumber;
+    const char *error; // NULL if the operation was applied
+    int accountNumber; // The account the result reports and its balance right after the operation
+    long long balance;
+    int reservedNumber; // For an account creation, the number reserved for it before the workers start; 0 if none
+} BatchOp;
+
+// The operations of a batch in line order; workers take the next BATCH_CLAIM_OPS unclaimed ones at a time
+typedef struct {
+    AccountTable *table;
+    BatchOp *ops;
+    size_t count;
+    pthread_mutex_t lock; // Guards next
+    size_t next;
+} BatchQueue;
+
 void welcome();
-void login(Account *user, cJSON *json);
-void menu(Account *user, cJSON *json);
-void newAccount(cJSON *json);
-void checkBalance(const Account *user, cJSON *json);
-void deposit(Account *user, cJSON *json);
-void withdraw(Account *user, cJSON *json);
-void changePin(Account *user, cJSON *json);
-void viewDetails(const Account *user, cJSON *json);
-void deleteAccount(Account *user, cJSON *json);
-void saveToFile(const cJSON *json, const char *filename);
+void login(Account *user, AccountTable *table);
+void menu(Account *user, AccountTable *table);
+void newAccount(AccountTable *table);
+void checkBalance(const Account *user, AccountTable *table);
+void deposit(Account *user, AccountTable *table);
+void withdraw(Account *user, AccountTable *table);
+void transfer(Account *user, AccountTable *table);
+void changePin(Account *user, AccountTable *table);
+void viewDetails(const Account *user, AccountTable *table);
+void deleteAccount(Account *user, AccountTable *table);
+int snapshotCreate();
+size_t saveToFile(const AccountTable *table, int fd);
+void snapshotWrite(SnapshotWriter *writer, const char *data, size_t length);
+void snapshotFlush(SnapshotWriter *writer);
+void writeAll(int fd, const char *data, size_t length);
+int parseAccountLines(const char *data, size_t size, AccountTable *table);
+void *parseLineChunk(void *arg);
+int decodeAccountDocument(const char *data, size_t size, AccountTable *table);
+int decodeAccountLines(const char *begin, const char *end, AccountTable *table);
+int decodeAccount(Decoder *decoder);
+int decodeKey(Decoder *decoder, const char *key);
+int decodeString(Decoder *decoder, size_t *offset);
+int decodeAccountNumber(Decoder *decoder, int *accountNumber);
+int decodeSequence(Decoder *decoder, unsigned long long *number);
+int decodeAmount(Decoder *decoder, long long *amount);
+size_t decodeNumberText(Decoder *decoder, char *digits, size_t size);
+int decodeByte(Decoder *decoder, char byte);
+void decodeSpace(Decoder *decoder);
+size_t tableAdd(AccountTable *table, int accountNumber, long long balance, const char *const values[]);
+size_t tableAddRecord(AccountTable *table, const char *text, size_t length);
+size_t tableAddJSON(AccountTable *table, const cJSON *account);
+unsigned long long sequenceValue(const cJSON *item);
+int tableLoadJSON(AccountTable *table, const cJSON *json);
+void tableAppendTable(AccountTable *table, AccountTable *rows);
+const char *tableString(const AccountTable *table, size_t row, AccountField field);
+void tableSetString(AccountTable *table, size_t row, AccountField field, const char *value);
+void tableRemove(AccountTable *table, size_t row);
+void tableCompact(AccountTable *table);
+void tableReserveRows(AccountTable *table, size_t rows);
+size_t tableAddString(AccountTable *table, const char *value);
+char *tableReserveStrings(AccountTable *table, size_t bytes);
+void tableFree(AccountTable *table);
+void encoderInit();
+void encodeAccounts(const AccountTable *table, int pretty, int lines, SnapshotWriter *writer);
+void *encodeRange(void *arg);
+void encodeAccount(const AccountTable *table, size_t row, const AccountLayout *layout, EncodeBuffer *out);
+void encodeText(EncodeBuffer *out, const char *text, size_t length);
+char *encodeReserve(EncodeBuffer *out, size_t bytes);
+size_t parallelism(size_t bytes);
+size_t coreCount();
+void runParallel(void *(*task)(void *), void *tasks, size_t taskSize, size_t count);
+void parseArguments(int argc, char *argv[]);
+int parseAmount(const char *text, long long *amount);
+int readAmount(long long *amount);
+int readAccountNumber(int *accountNumber);
+int amountFromDouble(double value, long long *amount);
+int addAmount(long long balance, long long amount, long long *result);
+size_t formatAmount(long long amount, char *buffer, int bothDecimals);
+void runBatch(AccountTable *table, const char *opsFile, const char *resultsFile);
+void *batchWorkerRun(void *arg);
+const char *batchApply(AccountTable *table, BatchOp *op);
+const char *batchUpdate(AccountTable *table, char op, const char *accountText, const char *toAccountText,
+                        const char *value, BatchOp *result);
+size_t batchAccount(const char *text);
+char *batchField(char **at);
+void lockAccounts(int accountNumber, int otherAccountNumber);
+void unlockAccounts(int accountNumber, int otherAccountNumber);
+void snapshotCommit(int fd, const char *filename);
+void syncDirectory();
 void delay(int number_of_seconds);
-int randomNumber(cJSON *json);
-int accountNumberExists(int num, cJSON *accounts, int size);
-cJSON *loadFromFile(const char *filename);
-
-int main() {
-    welcome();
-    cJSON *json = loadFromFile("accounts.json");
-    if (json == NULL) {
-        json = cJSON_CreateObject();
-        cJSON_AddItemToObject(json, "accounts", cJSON_CreateArray());
+int randomNumber();
+void accountNumbersInit();
+void accountNumbersMark(int num);
+void accountNumbersRelease(int num);
+int accountNumbersNextFree(size_t bit);
+size_t reserveAccountNumbers(int *numbers, size_t count);
+void *poolMalloc(size_t size);
+void poolFree(void *pointer);
+void poolRelease();
+void internKeys();
+void loadFromFile(const char *filename, AccountTable *table);
+void journalOpen(const char *filename);
+void journalStart();
+void journalClose();
+unsigned long long journalAppend(const char *record, size_t length, unsigned long long seq);
+void journalFlushLocked();
+void journalCommit(unsigned long long seq);
+void *journalFlusherRun(void *arg);
+unsigned long long journalBalance(char op, int accountNumber, long long amount, long long balance);
+unsigned long long journalTransfer(int accountNumber, int toAccountNumber, long long amount, long long balance,
+                                   long long toBalance);
+unsigned long long journalPin(int accountNumber, const char *pin);
+unsigned long long journalCreate(const AccountTable *table, size_t row);
+unsigned long long journalDelete(int accountNumber);
+void journalReplay(AccountTable *table, const char *filename);
+int journalApply(AccountTable *table, const char *record);
+void journalRotate();
+void checkpoint(AccountTable *table);
+void checkpointerStart(AccountTable *table);
+void checkpointerStop();
+void *checkpointerRun(void *arg);
+size_t userAccount(const Account *user, const AccountTable *table);
+void indexBuild(const AccountTable *table);
+void indexInsert(int accountNumber, size_t row);
+void indexRemove(int accountNumber);
+size_t indexFind(int accountNumber);
+void indexFree();
+size_t indexSlot(int accountNumber, size_t capacity);
+void indexResize(size_t capacity);
+
+int main(int argc, char *argv[]) {
+    parseArguments(argc, argv);
+
+    cJSON_Hooks hooks = { poolMalloc, poolFree };
+    cJSON_InitHooks(&hooks);
+    internKeys();
+    encoderInit();
+
+    if (batchFile == NULL) {
+        welcome();
+    }
+    AccountTable table = { 0 };
+    loadFromFile(JSON_FILE, &table);
+    journalOpen(JOURNAL_FILE);
+    journalStart();
+    if (access(JOURNAL_OLD_FILE, F_OK) == 0) {
+        // The last checkpoint did not finish; fold its journal into a snapshot before it can be overwritten
+        checkpoint(&table);
     }
 
-    Account currentUser;
-    login(&currentUser, json);
-    menu(&currentUser, json);
+    if (batchFile != NULL) {
+        runBatch(&table, batchFile, batchOutFile); // Saves the snapshot itself
+    } else {
+        checkpointerStart(&table);
+
+        Account currentUser;
+        login(&currentUser, &table);
+        menu(&currentUser, &table);
 
-    cJSON_Delete(json);
+        checkpointerStop();
+        checkpoint(&table);
+    }
+    journalClose();
+    poolRelease(); // Frees whatever cJSON allocated at once
+    tableFree(&table);
+    indexFree();
+    free(accountNumbers.usedBits);
+    free(accountNumbers.fullWords);
 
     return 0;
 }
@@ -110,59 +580,52 @@ void welcome() {
     // system("clear"); // For Windows, use "cls".
 }
 
-void login(Account *user, cJSON *json) {
+void login(Account *user, AccountTable *table) {
     char* currentUser;
 
     printf("Enter your account number: ");
     scanf("%s", user->accountNumber);
 
-    cJSON *accounts = cJSON_GetObjectItem(json, "accounts");
-
-    if (cJSON_IsArray(accounts)) {
-        int arraySize = cJSON_GetArraySize(accounts);
-        for (int i = 0; i < arraySize; i++) {
-            cJSON *account = cJSON_GetArrayItem(accounts, i);
-            const char *name = cJSON_GetObjectItem(account, "name")->valuestring;
-            const int accNumber = cJSON_GetObjectItem(account, "accountNumber")->valueint;
-            const char *securityQuestion = cJSON_GetObjectItem(account, "securityQuestion")->valuestring;
-            const char *securityAnswer = cJSON_GetObjectItem(account, "securityAnswer")->valuestring;
-            const char *pin = cJSON_GetObjectItem(account, "pin")->valuestring;
-
-            if (accNumber == strtol(user->accountNumber, &currentUser, 10)) {
-                strcpy(user->name, name);
-                printf("Enter your password or type 'forgot' to recover it: ");
-                scanf("%s", user->pin);
-
-                if (strcmp(user->pin, "forgot") == 0) {
-                    printf("Security question: %s\n", securityQuestion);
-                    printf("Answer: ");
-                    char secuAnswer[MAX_NAME_LENGTH];
-                    scanf("%s", secuAnswer);
-                    if (strcmp(secuAnswer, securityAnswer) == 0) {
-                        printf("Your password is: %s\n", pin);
-                        delay(1);
-                        system("clear"); // For Windows, use "cls".
-                        login(user, json);
-                    } else {
-                        printf("Incorrect answer\n");
-                        delay(1);
-                        system("clear"); // For Windows, use "cls".
-                        login(user, json);
-                    }
-                }
-                if (strcmp(user->pin, pin) == 0) {
-                    printf("Login successful\n");
-                    delay(1);
-                    // system("clear"); // For Windows, use "cls".
-                    return;
-                } else {
-                    printf("Incorrect pin\n");
-                    delay(1);
-                    system("clear"); // For Windows, use "cls"
-                    login(user, json);
-                }
+    size_t row = indexFind((int) strtol(user->accountNumber, &currentUser, 10));
+    if (row != NO_ROW) {
+        const char *name = tableString(table, row, FIELD_NAME);
+        const char *securityQuestion = tableString(table, row, FIELD_SECURITY_QUESTION);
+        const char *securityAnswer = tableString(table, row, FIELD_SECURITY_ANSWER);
+        const char *pin = tableString(table, row, FIELD_PIN);
+
+        strcpy(user->name, name);
+        printf("Enter your password or type 'forgot' to recover it: ");
+        scanf("%s", user->pin);
+
+        if (strcmp(user->pin, "forgot") == 0) {
+            printf("Security question: %s\n", securityQuestion);
+            printf("Answer: ");
+            char secuAnswer[MAX_NAME_LENGTH];
+            scanf("%s", secuAnswer);
+            if (strcmp(secuAnswer, securityAnswer) == 0) {
+                printf("Your password is: %s\n", pin);
+                delay(1);
+                system("clear"); // For Windows, use "cls".
+                login(user, table);
+            } else {
+                printf("Incorrect answer\n");
+                delay(1);
+                system("clear"); // For Windows, use "cls".
+                login(user, table);
             }
-
+            return;
+        }
+        if (strcmp(user->pin, pin) == 0) {
+            printf("Login successful\n");
+            delay(1);
+            // system("clear"); // For Windows, use "cls".
+            return;
+        } else {
+            printf("Incorrect pin\n");
+            delay(1);
+            system("clear"); // For Windows, use "cls"
+            login(user, table);
+            return;
         }
     }
 
@@ -172,18 +635,17 @@ void login(Account *user, cJSON *json) {
 
     if (strcmp((const char *) createNewAccount, "yes") == 0) {
         printf("Creating new account...\n");
-        newAccount(json);
-        saveToFile(json, "accounts.json");
-        login(user, json); // Reattempt login after creating the account
+        newAccount(table);
+        login(user, table); // Reattempt login after creating the account
     } else {
         printf("Login failed\n");
         delay(1);
         // system("clear"); // "cls".
-        login(user, json);
+        login(user, table);
     }
 }
 
-void menu(Account *user, cJSON *json) {
+void menu(Account *user, AccountTable *table) {
     int choice;
     do {
         printf("\n---------------------\n");
@@ -195,39 +657,42 @@ void menu(Account *user, cJSON *json) {
         printf("6. Logout\n");
         printf("7. View details\n");
         printf("8. Delete account\n");
+        printf("10. Transfer\n");
         printf("---------------------\n");
         printf("Enter your choice: ");
         scanf("%d", &choice);
 
         switch (choice) {
             case 1:
-                newAccount(json);
+                newAccount(table);
                 break;
             case 2:
-                checkBalance(user, json);
+                checkBalance(user, table);
                 break;
             case 3:
-                deposit(user, json);
+                deposit(user, table);
                 break;
             case 4:
-                withdraw(user, json);
+                withdraw(user, table);
                 break;
             case 5:
-                changePin(user, json);
+                changePin(user, table);
                 break;
             case 6:
                 printf("Logged out successfully\n");
                 delay(1);
                 system("clear"); // For Windows, use "cls".
-                login(user, json);
+                login(user, table);
                 break;
             case 7:
-                viewDetails(user, json);
+                viewDetails(user, table);
                 break;
             case 8:
-                deleteAccount(user, json);
-                saveToFile(json, "accounts.json");
-                login(user, json); // Reattempt login after deleting the account
+                deleteAccount(user, table);
+                login(user, table); // Reattempt login after deleting the account
+                break;
+            case 10:
+                transfer(user, table);
                 break;
             default:
                 printf("Invalid choice\n");
@@ -238,9 +703,9 @@ void menu(Account *user, cJSON *json) {
     } while (choice != 9);
 }
 
-void newAccount(cJSON *json) {
+void newAccount(AccountTable *table) {
     Account newAccount;
-    int accountNumber = randomNumber(json);
+    int accountNumber = randomNumber();
     char securityAnswer[MAX_NAME_LENGTH];
     char securityQuestion[MAX_NAME_LENGTH];
 
@@ -263,7 +728,9 @@ void newAccount(cJSON *json) {
     printf("Enter a pin for your account: ");
     scanf("%s", newAccount.pin);
     printf("Enter your balance: ");
-    scanf("%lf", &newAccount.balance);
+    while (!readAmount(&newAccount.balance)) {
+        printf("Invalid amount. Enter your balance: ");
+    }
     getchar();
     printf("Please enter a security question that you will be able to answer in case you forget your pin: ");
     fgets(securityQuestion, MAX_NAME_LENGTH, stdin);
@@ -273,52 +740,36 @@ void newAccount(cJSON *json) {
     printf("Your account number is: %d\nPlease copy or remember it.", accountNumber);
     printf("\n---------------------\n");
 
-    cJSON *accountObject = cJSON_CreateObject();
-    cJSON_AddStringToObject(accountObject, "name", newAccount.name);
-    cJSON_AddStringToObject(accountObject, "country", newAccount.country);
-    cJSON_AddStringToObject(accountObject, "state", newAccount.state);
-    cJSON_AddStringToObject(accountObject, "city", newAccount.city);
-    cJSON_AddStringToObject(accountObject, "street", newAccount.street);
-    cJSON_AddStringToObject(accountObject, "houseNumber", newAccount.houseNumber);
-    cJSON_AddStringToObject(accountObject, "phone", newAccount.phone);
-    cJSON_AddStringToObject(accountObject, "pin", newAccount.pin);
-    cJSON_AddStringToObject(accountObject, "securityQuestion", securityQuestion);
-    cJSON_AddStringToObject(accountObject, "securityAnswer", securityAnswer);
-    cJSON_AddNumberToObject(accountObject, "accountNumber", accountNumber);
-    cJSON_AddNumberToObject(accountObject, "balance", newAccount.balance);
+    // In AccountField order
+    const char *values[ACCOUNT_STRING_FIELDS] = {
+        newAccount.name, newAccount.country, newAccount.state, newAccount.city, newAccount.street,
+        newAccount.houseNumber, newAccount.phone, newAccount.pin, securityQuestion, securityAnswer
+    };
 
-    cJSON *accounts = cJSON_GetObjectItem(json, "accounts");
-    if (accounts == NULL) {
-        accounts = cJSON_CreateArray();
-        cJSON_AddItemToObject(json, "accounts", accounts);
-    }
-
-    cJSON_AddItemToArray(accounts, accountObject);
+    pthread_mutex_lock(&bankMutex);
+    size_t row = tableAdd(table, accountNumber, newAccount.balance, values);
+    indexInsert(accountNumber, row);
+    unsigned long long seq = journalCreate(table, row);
+    pthread_mutex_unlock(&bankMutex);
+    journalCommit(seq);
 
     printf("\nAccount created successfully\n");
     delay(1);
     // system("clear"); // For Windows, use "cls".
 }
 
-void checkBalance(const Account *user, cJSON *json) {
-    cJSON *accounts = cJSON_GetObjectItem(json, "accounts");
-    if (cJSON_IsArray(accounts)) {
-        int arraySize = cJSON_GetArraySize(accounts);
-        for (int i = 0; i < arraySize; i++) {
-            cJSON *account = cJSON_GetArrayItem(accounts, i);
-            const int accNumber = cJSON_GetObjectItem(account, "accountNumber")->valueint;
-            const char *pin = cJSON_GetObjectItem(account, "pin")->valuestring;
-            double balance = cJSON_GetObjectItem(account, "balance")->valuedouble;
-
-            if (strcmp(user->pin, pin) == 0 && accNumber == strtol(user->accountNumber, NULL, 10)) {
-                printf("\n---------------------\n");
-                printf("Your balance is %.2lf\n", balance);
-                printf("---------------------\n");
-                delay(1);
-                system("clear"); // For Windows, use "cls".
-                return;
-            }
-        }
+void checkBalance(const Account *user, AccountTable *table) {
+    size_t row = userAccount(user, table);
+    if (row != NO_ROW) {
+        char balance[AMOUNT_LENGTH];
+        formatAmount(table->balances[row], balance, 1);
+
+        printf("\n---------------------\n");
+        printf("Your balance is %s\n", balance);
+        printf("---------------------\n");
+        delay(1);
+        system("clear"); // For Windows, use "cls".
+        return;
     }
 
     printf("Account not found\n");
@@ -326,144 +777,195 @@ void checkBalance(const Account *user, cJSON *json) {
     // system("clear"); // For Windows, use "cls".
 }
 
-void deposit(Account *user, cJSON *json) {
-    double amount;
+void deposit(Account *user, AccountTable *table) {
+    long long amount;
     printf("Enter the amount you want to deposit: ");
-    scanf("%lf", &amount);
-
-    cJSON *accounts = cJSON_GetObjectItem(json, "accounts");
-    if (cJSON_IsArray(accounts)) {
-        int arraySize = cJSON_GetArraySize(accounts);
-        for (int i = 0; i < arraySize; i++) {
-            cJSON *account = cJSON_GetArrayItem(accounts, i);
-            const int accNumber = cJSON_GetObjectItem(account, "accountNumber")->valueint;
-            const char *pin = cJSON_GetObjectItem(account, "pin")->valuestring;
-            double balance = cJSON_GetObjectItem(account, "balance")->valuedouble;
-
-            if (strcmp(user->pin, pin) == 0 && accNumber == strtol(user->accountNumber, NULL, 10)) {
-                cJSON_SetNumberValue(cJSON_GetObjectItem(account, "balance"), balance + amount);
-                saveToFile(json, JSON_FILE);
-                printf("Amount deposited successfully\n");
-                return;
-            }
+    if (!readAmount(&amount) || amount <= 0) {
+        printf("Invalid amount\n");
+        return;
+    }
+
+    size_t row = userAccount(user, table);
+    if (row != NO_ROW) {
+        long long balance = table->balances[row];
+        long long newBalance;
+        if (!addAmount(balance, amount, &newBalance)) {
+            printf("Invalid amount\n");
+            return;
         }
+
+        pthread_mutex_lock(&bankMutex);
+        table->balances[row] = newBalance;
+        unsigned long long seq = journalBalance('D', table->accountNumbers[row], amount, newBalance);
+        pthread_mutex_unlock(&bankMutex);
+        journalCommit(seq);
+        printf("Amount deposited successfully\n");
+        return;
     }
 
     printf("Account not found\n");
 }
 
-void withdraw(Account *user, cJSON *json) {
-    double amount;
+void withdraw(Account *user, AccountTable *table) {
+    long long amount;
     printf("Enter the amount you want to withdraw: ");
-    scanf("%lf", &amount);
-
-    cJSON *accounts = cJSON_GetObjectItem(json, "accounts");
-    if (cJSON_IsArray(accounts)) {
-        int arraySize = cJSON_GetArraySize(accounts);
-        for (int i = 0; i < arraySize; i++) {
-            cJSON *account = cJSON_GetArrayItem(accounts, i);
-            const int accNumber = cJSON_GetObjectItem(account, "accountNumber")->valueint;
-            const char *pin = cJSON_GetObjectItem(account, "pin")->valuestring;
-            double balance = cJSON_GetObjectItem(account, "balance")->valuedouble;
-
-            if (strcmp(user->pin, pin) == 0 && accNumber == strtol(user->accountNumber, NULL, 10)) {
-                if (balance < amount) {
-                    printf("Insufficient balance\n");
-                    return;
-                }
+    if (!readAmount(&amount) || amount <= 0) {
+        printf("Invalid amount\n");
+        return;
+    }
 
-                if(amount > 1000) {
-                    printf("Enter pin to continue: ");
-                    char conPin[MAX_PIN_LENGTH];
-                    scanf("%s", conPin);
-                    if(strcmp(conPin, pin) != 0) {
-                        printf("Incorrect pin\n");
-                        return;
-                    }
-                    cJSON_SetNumberValue(cJSON_GetObjectItem(account, "balance"), balance - amount);
-                    saveToFile(json, JSON_FILE);
-                    printf("Amount withdrawn successfully\n");
-                }
-                cJSON_SetNumberValue(cJSON_GetObjectItem(account, "balance"), balance - amount);
-                saveToFile(json, JSON_FILE);
-                printf("Amount withdrawn successfully\n");
+    size_t row = userAccount(user, table);
+    if (row != NO_ROW) {
+        const char *pin = tableString(table, row, FIELD_PIN);
+        long long balance = table->balances[row];
+
+        if (balance < amount) {
+            printf("Insufficient balance\n");
+            return;
+        }
+
+        if(amount > 1000 * MINOR_UNITS) {
+            printf("Enter pin to continue: ");
+            char conPin[MAX_PIN_LENGTH];
+            scanf("%s", conPin);
+            if(strcmp(conPin, pin) != 0) {
+                printf("Incorrect pin\n");
                 return;
             }
         }
+        pthread_mutex_lock(&bankMutex);
+        table->balances[row] = balance - amount;
+        unsigned long long seq = journalBalance('W', table->accountNumbers[row], amount, balance - amount);
+        pthread_mutex_unlock(&bankMutex);
+        journalCommit(seq);
+        printf("Amount withdrawn successfully\n");
+        return;
     }
 
     printf("Account not found\n");
 }
 
-void changePin(Account *user, cJSON *json) {
+void transfer(Account *user, AccountTable *table) {
+    int toAccountNumber;
+    long long amount;
+    printf("Enter the account number to transfer to: ");
+    if (!readAccountNumber(&toAccountNumber)) {
+        printf("Invalid account number\n");
+        return;
+    }
+    printf("Enter the amount you want to transfer: ");
+    if (!readAmount(&amount) || amount <= 0) {
+        printf("Invalid amount\n");
+        return;
+    }
+
+    size_t row = userAccount(user, table);
+    if (row == NO_ROW) {
+        printf("Account not found\n");
+        return;
+    }
+    size_t toRow = indexFind(toAccountNumber);
+    if (toRow == row) {
+        printf("Cannot transfer to the same account\n");
+        return;
+    }
+    if (toRow == NO_ROW) {
+        printf("Recipient account not found\n");
+        return;
+    }
+
+    if (amount > 1000 * MINOR_UNITS) {
+        printf("Enter pin to continue: ");
+        char conPin[MAX_PIN_LENGTH];
+        scanf("%5s", conPin);
+        if (strcmp(conPin, tableString(table, row, FIELD_PIN)) != 0) {
+            printf("Incorrect pin\n");
+            return;
+        }
+    }
+
+    // Both balances change under one lock and go to the journal as one record, so no crash can split them
+    pthread_mutex_lock(&bankMutex);
+    if (table->balances[row] < amount) {
+        pthread_mutex_unlock(&bankMutex);
+        printf("Insufficient balance\n");
+        return;
+    }
+    long long toBalance;
+    if (!addAmount(table->balances[toRow], amount, &toBalance)) {
+        pthread_mutex_unlock(&bankMutex);
+        printf("Invalid amount\n");
+        return;
+    }
+    table->balances[row] -= amount;
+    table->balances[toRow] = toBalance;
+    unsigned long long seq = journalTransfer(table->accountNumbers[row], toAccountNumber, amount, table->balances[row],
+                                             table->balances[toRow]);
+    pthread_mutex_unlock(&bankMutex);
+    journalCommit(seq);
+    printf("Amount transferred successfully\n");
+}
+
+void changePin(Account *user, AccountTable *table) {
     char newPin[MAX_NAME_LENGTH];
 
-    cJSON *accounts = cJSON_GetObjectItem(json, "accounts");
-    if (cJSON_IsArray(accounts)) {
-        int arraySize = cJSON_GetArraySize(accounts);
-        for (int i = 0; i < arraySize; i++) {
-            cJSON *account = cJSON_GetArrayItem(accounts, i);
-            const int accNumber = cJSON_GetObjectItem(account, "accountNumber")->valueint;
-            const char *pin = cJSON_GetObjectItem(account, "pin")->valuestring;
-
-            if (strcmp(user->pin, pin) == 0 && accNumber == strtol(user->accountNumber, NULL, 10)) {
-                printf("Enter old pin to continue: ");
-                char oldPin[MAX_PIN_LENGTH];
-                scanf("%s", oldPin);
-                if(strcmp(oldPin, pin) != 0) {
-                    printf("Incorrect pin\n");
-                    return;
-                }
-                printf("Enter new pin: ");
-                scanf("%s", newPin);
-                cJSON_SetValuestring(cJSON_GetObjectItem(account, "pin"), newPin);
-                saveToFile(json, JSON_FILE);
-                printf("Pin changed successfully\n");
-                printf("Please login again\n");
-                delay(1);
-                // system("clear"); // For Windows, use "cls".
-                login(user, json);
-                return;
-            }
+    size_t row = userAccount(user, table);
+    if (row != NO_ROW) {
+        const char *pin = tableString(table, row, FIELD_PIN);
+
+        printf("Enter old pin to continue: ");
+        char oldPin[MAX_PIN_LENGTH];
+        scanf("%s", oldPin);
+        if(strcmp(oldPin, pin) != 0) {
+            printf("Incorrect pin\n");
+            return;
         }
+        printf("Enter new pin: ");
+        scanf("%s", newPin);
+        pthread_mutex_lock(&bankMutex);
+        tableSetString(table, row, FIELD_PIN, newPin);
+        unsigned long long seq = journalPin(table->accountNumbers[row], newPin);
+        pthread_mutex_unlock(&bankMutex);
+        journalCommit(seq);
+        printf("Pin changed successfully\n");
+        printf("Please login again\n");
+        delay(1);
+        // system("clear"); // For Windows, use "cls".
+        login(user, table);
+        return;
     }
     printf("Account not found\n");
     printf("The user had to be logged out due to a technical glitch.\nPlease login again\n");
     delay(1);
-    login(user, json);
-}
-
-void viewDetails(const Account *user, cJSON *json) {
-    cJSON *accounts = cJSON_GetObjectItem(json, "accounts");
-    if (cJSON_IsArray(accounts)) {
-        int arraySize = cJSON_GetArraySize(accounts);
-        for (int i = 0; i < arraySize; i++) {
-            cJSON *account = cJSON_GetArrayItem(accounts, i);
-            const char *name = cJSON_GetObjectItem(account, "name")->valuestring;
-            const char *country = cJSON_GetObjectItem(account, "country")->valuestring;
-            const char *state = cJSON_GetObjectItem(account, "state")->valuestring;
-            const char *city = cJSON_GetObjectItem(account, "city")->valuestring;
-            const char *street = cJSON_GetObjectItem(account, "street")->valuestring;
-            const char *houseNumber = cJSON_GetObjectItem(account, "houseNumber")->valuestring;
-            const char *phone = cJSON_GetObjectItem(account, "phone")->valuestring;
-            const char *pin = cJSON_GetObjectItem(account, "pin")->valuestring;
-            int accountNumber = cJSON_GetObjectItem(account, "accountNumber")->valueint;
-            double balance = cJSON_GetObjectItem(account, "balance")->valuedouble;
-
-            if (strcmp(user->pin, pin) == 0 && accountNumber == strtol(user->accountNumber, NULL, 10)) {
-                printf("\n---------------------\n");
-                printf("Name: %s\n", name);
-                printf("Address: \nCountry: %s\nState: %s\nCity: %s\nStreet: %s\nHouse number: %s\n", country, state, city, street, houseNumber);
-                printf("Phone number: %s\n", phone);
-                printf("Pin: %s\n", pin);
-                printf("Account number: %d\n", accountNumber);
-                printf("Balance: %.2lf\n", balance);
-                printf("---------------------\n");
-                delay(1);
-                // system("clear"); // For Windows, use "cls".
-                return;
-            }
-        }
+    login(user, table);
+}
+
+void viewDetails(const Account *user, AccountTable *table) {
+    size_t row = userAccount(user, table);
+    if (row != NO_ROW) {
+        const char *name = tableString(table, row, FIELD_NAME);
+        const char *country = tableString(table, row, FIELD_COUNTRY);
+        const char *state = tableString(table, row, FIELD_STATE);
+        const char *city = tableString(table, row, FIELD_CITY);
+        const char *street = tableString(table, row, FIELD_STREET);
+        const char *houseNumber = tableString(table, row, FIELD_HOUSE_NUMBER);
+        const char *phone = tableString(table, row, FIELD_PHONE);
+        const char *pin = tableString(table, row, FIELD_PIN);
+        int accountNumber = table->accountNumbers[row];
+        char balance[AMOUNT_LENGTH];
+        formatAmount(table->balances[row], balance, 1);
+
+        printf("\n---------------------\n");
+        printf("Name: %s\n", name);
+        printf("Address: \nCountry: %s\nState: %s\nCity: %s\nStreet: %s\nHouse number: %s\n", country, state, city, street, houseNumber);
+        printf("Phone number: %s\n", phone);
+        printf("Pin: %s\n", pin);
+        printf("Account number: %d\n", accountNumber);
+        printf("Balance: %s\n", balance);
+        printf("---------------------\n");
+        delay(1);
+        // system("clear"); // For Windows, use "cls".
+        return;
     }
 
     printf("Account not found\n");
@@ -471,35 +973,24 @@ void viewDetails(const Account *user, cJSON *json) {
     // system("clear"); // For Windows, use "cls".
 }
 
-void deleteAccount(Account *user, cJSON *json) {
+void deleteAccount(Account *user, AccountTable *table) {
     char *confirm = malloc(sizeof(char) * 3);
     char conPin[MAX_PIN_LENGTH];
 
 
-    cJSON *accounts = cJSON_GetObjectItem(json, "accounts");
-    if (cJSON_IsArray(accounts)) {
-        int arraySize = cJSON_GetArraySize(accounts);
-        cJSON *newAccounts = cJSON_CreateArray();
-        for (int i = 0; i < arraySize; i++) {
-            cJSON *account = cJSON_GetArrayItem(accounts, i);
-            const int accNumber = cJSON_GetObjectItem(account, "accountNumber")->valueint;
-            const char *pin = cJSON_GetObjectItem(account, "pin")->valuestring;
-            int balance = cJSON_GetObjectItem(account, "balance")->valueint;
-
-            if (strcmp(user->pin, pin) == 0 && accNumber == strtol(user->accountNumber, NULL, 10)) {
-                if(balance > 0) {
-                    printf("You have a balance of %d in your account. Please withdraw the amount to continue\n"
-                           "You were logged out for security reasons.\n"
-                           "Please login again.\n", balance);
-                    return;
-                }
-                continue;
-            }
+    size_t row = userAccount(user, table);
+    if (row != NO_ROW) {
+        const int accNumber = table->accountNumbers[row];
+        char balance[AMOUNT_LENGTH];
+        formatAmount(table->balances[row], balance, 1);
 
-            cJSON_AddItemToArray(newAccounts, cJSON_Duplicate(account, 1));
+        if(table->balances[row] > 0) {
+            printf("You have a balance of %s in your account. Please withdraw the amount to continue\n"
+                   "You were logged out for security reasons.\n"
+                   "Please login again.\n", balance);
+            return;
         }
 
-
         printf("Enter your pin to continue: ");
         scanf("%s", conPin);
         if(strcmp(conPin, user->pin) != 0) {
@@ -515,8 +1006,11 @@ void deleteAccount(Account *user, cJSON *json) {
             return;
         }
 
-        cJSON_DeleteItemFromObject(json, "accounts");
-        cJSON_AddItemToObject(json, "accounts", newAccounts);
+        pthread_mutex_lock(&bankMutex);
+        tableRemove(table, row);
+        unsigned long long seq = journalDelete(accNumber);
+        pthread_mutex_unlock(&bankMutex);
+        journalCommit(seq);
         printf("Account deleted successfully\n");
         delay(1);
 
@@ -528,109 +1022,2117 @@ void deleteAccount(Account *user, cJSON *json) {
     }
 }
 
-void saveToFile(const cJSON *json, const char *filename) {
-    FILE *file = fopen(filename, "w");
-    if (file == NULL) {
-        perror("Error opening file. Function saveToFile()");
+int snapshotCreate() {
+    // The snapshot goes to a temporary file that is renamed over the old one, so a crash never leaves a half-written file
+    int fd = open(JSON_TEMP_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("Error opening file. Function snapshotCreate()");
         exit(EXIT_FAILURE);
     }
+    return fd;
+}
 
-    char *jsonStr = cJSON_Print(json);
-    if (jsonStr == NULL) {
-        perror("Error creating JSON string. Function saveToFile()");
-        fclose(file);
-        exit(EXIT_FAILURE);
+size_t saveToFile(const AccountTable *table, int fd) {
+    // Streams the document in fixed-size chunks, so memory use doesn't grow with the bank and there is no 2 GB limit
+    static SnapshotWriter writer; // Too big for the stack; only one checkpoint runs at a time
+    writer.fd = fd;
+    writer.bytes = 0;
+    writer.used = 0;
+
+    if (storageFormat == FORMAT_JSONL) {
+        char header[128];
+        int length = snprintf(header, sizeof(header), JSONL_HEADER ",\"%s\":%llu}\n", KEY_JOURNAL_SEQ,
+                              table->journalSeq);
+        snapshotWrite(&writer, header, (size_t) length);
+        encodeAccounts(table, 0, 1, &writer);
+    } else {
+        // Same bytes cJSON_Print/cJSON_PrintUnformatted would produce for the document
+        int pretty = storageFormat == FORMAT_PRETTY;
+        char text[128];
+        int length = snprintf(text, sizeof(text), pretty ? "{\n\t\"%s\":\t[" : "{\"%s\":[", KEY_ACCOUNTS);
+        snapshotWrite(&writer, text, (size_t) length);
+        encodeAccounts(table, pretty, 0, &writer);
+        length = snprintf(text, sizeof(text), pretty ? "],\n\t\"%s\":\t%llu\n}" : "],\"%s\":%llu}", KEY_JOURNAL_SEQ,
+                          table->journalSeq);
+        snapshotWrite(&writer, text, (size_t) length);
     }
 
-    fprintf(file, "%s", jsonStr);
+    snapshotFlush(&writer);
+    return writer.bytes;
+}
 
-    fclose(file);
-    cJSON_free(jsonStr);
+void snapshotWrite(SnapshotWriter *writer, const char *data, size_t length) {
+    if (writer->used + length > sizeof(writer->buffer)) {
+        snapshotFlush(writer);
+    }
+    if (length >= sizeof(writer->buffer)) {
+        writeAll(writer->fd, data, length);
+    } else {
+        memcpy(writer->buffer + writer->used, data, length);
+        writer->used += length;
+    }
+    writer->bytes += length;
 }
 
-cJSON *loadFromFile(const char *filename) {
-    FILE *file = fopen(filename, "r");
-    if (file == NULL) {
-        // If the file doesn't exist, create it
-        file = fopen(filename, "w");
-        if (file == NULL) {
-            perror("Error creating file. Function loadFromFile()");
+void snapshotFlush(SnapshotWriter *writer) {
+    writeAll(writer->fd, writer->buffer, writer->used);
+    writer->used = 0;
+}
+
+void writeAll(int fd, const char *data, size_t length) {
+    size_t offset = 0;
+    while (offset < length) {
+        ssize_t written = write(fd, data + offset, length - offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Error writing file. Function writeAll()");
             exit(EXIT_FAILURE);
         }
-        fclose(file);
-        return NULL;
+        offset += (size_t) written;
     }
+}
 
-    fseek(file, 0, SEEK_END);
-    long fileSize = ftell(file);
-    fseek(file, 0, SEEK_SET);
+void snapshotCommit(int fd, const char *filename) {
+    if (fsync(fd) != 0 || close(fd) != 0) {
+        perror("Error flushing file. Function snapshotCommit()");
+        exit(EXIT_FAILURE);
+    }
+    if (rename(JSON_TEMP_FILE, filename) != 0) {
+        perror("Error replacing file. Function snapshotCommit()");
+        exit(EXIT_FAILURE);
+    }
+    syncDirectory();
+}
 
-    char *buffer = (char *)malloc(fileSize + 1);
-    if (buffer == NULL) {
-        perror("Error allocating memory. Function loadFromFile()");
-        fclose(file);
+// Makes renames and newly created files in the working directory durable; the files' own fsyncs don't cover that
+void syncDirectory() {
+    int fd = open(".", O_RDONLY | O_DIRECTORY);
+    if (fd < 0 || fsync(fd) != 0) {
+        perror("Error flushing directory. Function syncDirectory()");
         exit(EXIT_FAILURE);
     }
+    close(fd);
+}
 
-    size_t bytesRead = fread(buffer, 1, fileSize, file);
-//    if (bytesRead < fileSize) {
-//        perror("Error reading file. Function loadFromFile()");
-//        fclose(file);
-//        free(buffer);
-//        exit(EXIT_FAILURE);
-//    }
-// Problem when running on windows, windows cache system does not get cleared which means the program will always
-// read the same file size even if the file size has changed, the buffer will not be big enough to
-// store the file contents
-
-    buffer[fileSize] = '\0';
-
-    cJSON *json = cJSON_Parse(buffer);
-    if (json == NULL) {
-        perror("Error parsing JSON. Function loadFromFile()");
-        fclose(file);
-        free(buffer);
+void loadFromFile(const char *filename, AccountTable *table) {
+    // If the file doesn't exist, create it
+    int fd = open(filename, O_RDONLY | O_CREAT, 0644);
+    if (fd < 0) {
+        perror("Error opening file. Function loadFromFile()");
         exit(EXIT_FAILURE);
     }
 
-    fclose(file);
-    free(buffer);
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0) {
+        perror("Error reading file size. Function loadFromFile()");
+        close(fd);
+        exit(EXIT_FAILURE);
+    }
+
+    if (fileStat.st_size > 0) {
+        // Parse straight out of the page cache instead of copying the file into a heap buffer first
+        size_t fileSize = (size_t) fileStat.st_size;
+        void *mapping = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            perror("Error mapping file. Function loadFromFile()");
+            close(fd);
+            exit(EXIT_FAILURE);
+        }
+        // The parser reads the file once, front to back
+        madvise(mapping, fileSize, MADV_SEQUENTIAL);
+        madvise(mapping, fileSize, MADV_WILLNEED);
+
+        int loaded;
+        if (fileSize >= sizeof(JSONL_HEADER) - 1 && memcmp(mapping, JSONL_HEADER, sizeof(JSONL_HEADER) - 1) == 0) {
+            loaded = parseAccountLines(mapping, fileSize, table);
+        } else {
+            loaded = decodeAccountDocument(mapping, fileSize, table);
+            if (!loaded) {
+                // The accounts array is split at element boundaries and parsed on all cores, then copied into the table
+                tableFree(table);
+                cJSON *json = cJSON_ParseWithLengthParallel(mapping, fileSize, parallelism(fileSize), runParallel);
+                loaded = tableLoadJSON(table, json);
+                cJSON_Delete(json);
+            }
+        }
+        munmap(mapping, fileSize);
+        if (!loaded) {
+            perror("Error parsing JSON. Function loadFromFile()");
+            close(fd);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    close(fd);
 
-    return json;
+    indexBuild(table);
+    journalReplay(table, JOURNAL_OLD_FILE);
+    journalReplay(table, JOURNAL_FILE);
 }
 
-void delay(int number_of_seconds) {
-    int milli_seconds = 1000 * number_of_seconds;
-    clock_t start_time = clock();
+int parseAccountLines(const char *data, size_t size, AccountTable *table) {
+    const char *end = data + size;
+    const char *lineEnd = memchr(data, '\n', size);
+    if (lineEnd == NULL) {
+        lineEnd = end;
+    }
+    // The header this program writes is read exactly; anything else goes through cJSON
+    Decoder decoder = { data + strlen(JSONL_HEADER), lineEnd, table };
+    if (size < strlen(JSONL_HEADER) || memcmp(data, JSONL_HEADER, strlen(JSONL_HEADER)) != 0 ||
+        !decodeByte(&decoder, ',') || !decodeKey(&decoder, KEY_JOURNAL_SEQ) ||
+        !decodeSequence(&decoder, &table->journalSeq) || !decodeByte(&decoder, '}')) {
+        cJSON *header = cJSON_ParseWithLength(data, (size_t) (lineEnd - data));
+        cJSON *journalSeq = cJSON_GetObjectItem(header, KEY_JOURNAL_SEQ);
+        if (!cJSON_IsNumber(journalSeq)) {
+            cJSON_Delete(header);
+            return 0;
+        }
+        table->journalSeq = sequenceValue(journalSeq);
+        cJSON_Delete(header);
+    }
 
-    while (clock() < start_time + milli_seconds);
+    // Cut the body into equal slices, moving each cut forward to the next line start, and parse them concurrently
+    const char *body = lineEnd < end ? lineEnd + 1 : end;
+    size_t count = parallelism((size_t) (end - body));
+    LineChunk chunks[PARALLEL_MAX_THREADS];
+    const char *cut = body;
+    for (size_t i = 0; i < count; i++) {
+        chunks[i].begin = cut;
+        if (i + 1 == count) {
+            cut = end;
+        } else {
+            cut = body + (size_t) (end - body) * (i + 1) / count;
+            if (cut < chunks[i].begin) {
+                cut = chunks[i].begin;
+            }
+            const char *newline = memchr(cut, '\n', (size_t) (end - cut));
+            cut = newline == NULL ? end : newline + 1;
+        }
+        chunks[i].end = cut;
+        memset(&chunks[i].rows, 0, sizeof(AccountTable));
+        chunks[i].failed = 0;
+    }
+    runParallel(parseLineChunk, chunks, sizeof(LineChunk), count);
+
+    // Append the per-chunk rows to the table in file order
+    int failed = 0;
+    for (size_t i = 0; i < count; i++) {
+        failed |= chunks[i].failed;
+        tableAppendTable(table, &chunks[i].rows);
+    }
+    return !failed;
 }
 
-int randomNumber(cJSON *json) {
-    int num;
-    int lower = 10000000, upper = 99999999;
+void *parseLineChunk(void *arg) {
+    LineChunk *chunk = arg;
 
-    cJSON *accounts = cJSON_GetObjectItem(json, "accounts");
-    if (cJSON_IsArray(accounts)) {
-        int arraySize = cJSON_GetArraySize(accounts);
-        do {
-            num = (rand() % (upper - lower + 1)) + lower;
-        } while (accountNumberExists(num, accounts, arraySize));
-    } else {
-        num = (rand() % (upper - lower + 1)) + lower;
+    if (decodeAccountLines(chunk->begin, chunk->end, &chunk->rows)) {
+        return NULL;
     }
 
-    return num;
+    // Start over line by line, so only the lines the decoder can't take go through cJSON
+    tableFree(&chunk->rows);
+    const char *lineEnd = NULL;
+    for (const char *line = chunk->begin; line < chunk->end; line = lineEnd + 1) {
+        lineEnd = memchr(line, '\n', (size_t) (chunk->end - line));
+        if (lineEnd == NULL) {
+            lineEnd = chunk->end;
+        }
+        if (lineEnd == line) {
+            continue;
+        }
+        if (tableAddRecord(&chunk->rows, line, (size_t) (lineEnd - line)) == NO_ROW) {
+            chunk->failed = 1;
+            return NULL;
+        }
+    }
+    return NULL;
 }
 
-int accountNumberExists(int num, cJSON *accounts, int size) {
-    for (int i = 0; i < size; i++) {
-        cJSON *account = cJSON_GetArrayItem(accounts, i);
-        int accountNumber = cJSON_GetObjectItem(account, "accountNumber")->valueint;
+int decodeAccountDocument(const char *data, size_t size, AccountTable *table) {
+    Decoder decoder = { data, data + size, table };
+    int sawAccounts = 0;
 
-        if (accountNumber == num) {
-            return 1;
+    decodeSpace(&decoder);
+    if (!decodeByte(&decoder, '{')) {
+        return 0;
+    }
+    do {
+        if (decodeKey(&decoder, KEY_ACCOUNTS) && !sawAccounts) {
+            sawAccounts = 1;
+            if (!decodeByte(&decoder, '[')) {
+                return 0;
+            }
+            if (!decodeByte(&decoder, ']')) {
+                do {
+                    if (!decodeAccount(&decoder)) {
+                        return 0;
+                    }
+                } while (decodeByte(&decoder, ','));
+                if (!decodeByte(&decoder, ']')) {
+                    return 0;
+                }
+            }
+        } else if (decodeKey(&decoder, KEY_JOURNAL_SEQ)) {
+            if (!decodeSequence(&decoder, &table->journalSeq)) {
+                return 0;
+            }
+        } else {
+            return 0;
+        }
+    } while (decodeByte(&decoder, ','));
+
+    if (!decodeByte(&decoder, '}') || !sawAccounts) {
+        return 0;
+    }
+    decodeSpace(&decoder);
+    return decoder.at == decoder.end || *decoder.at == '\0';
+}
+
+int decodeAccountLines(const char *begin, const char *end, AccountTable *table) {
+    Decoder decoder = { begin, end, table };
+    decodeSpace(&decoder);
+    while (decoder.at < decoder.end) {
+        if (!decodeAccount(&decoder)) {
+            return 0;
+        }
+        decodeSpace(&decoder);
+    }
+    return 1;
+}
+
+int decodeAccount(Decoder *decoder) {
+    AccountTable *table = decoder->out;
+    tableReserveRows(table, 1);
+    size_t row = table->count;
+
+    if (!decodeByte(decoder, '{')) {
+        return 0;
+    }
+    for (int field = 0; field < ACCOUNT_STRING_FIELDS; field++) {
+        if (!decodeKey(decoder, ACCOUNT_STRING_KEYS[field]) || !decodeString(decoder, &table->fields[field][row]) ||
+            !decodeByte(decoder, ',')) {
+            return 0;
+        }
+    }
+    if (!decodeKey(decoder, KEY_ACCOUNT_NUMBER) || !decodeAccountNumber(decoder, &table->accountNumbers[row]) ||
+        !decodeByte(decoder, ',') || !decodeKey(decoder, KEY_BALANCE) ||
+        !decodeAmount(decoder, &table->balances[row]) || !decodeByte(decoder, '}')) {
+        return 0;
+    }
+    table->count++;
+    return 1;
+}
+
+// Matches "key" followed by a colon
+int decodeKey(Decoder *decoder, const char *key) {
+    size_t length = strlen(key);
+    decodeSpace(decoder);
+    if ((size_t) (decoder->end - decoder->at) < length + 2 || decoder->at[0] != '"' ||
+        memcmp(decoder->at + 1, key, length) != 0 || decoder->at[length + 1] != '"') {
+        return 0;
+    }
+    decoder->at += length + 2;
+    return decodeByte(decoder, ':');
+}
+
+int decodeString(Decoder *decoder, size_t *offset) {
+    decodeSpace(decoder);
+    if (decoder->at == decoder->end || *decoder->at != '"') {
+        return 0;
+    }
+    const char *start = ++decoder->at;
+    const char *close = start;
+    while (close < decoder->end && *close != '"' && *close != '\\') {
+        close++;
+    }
+    if (close == decoder->end) {
+        return 0;
+    }
+
+    // Unescaped strings (nearly all of them) are copied in one go; the rest go through the full rules
+    size_t length = (size_t) (close - start);
+    char *out = tableReserveStrings(decoder->out, length + 1);
+    *offset = decoder->out->stringsLength;
+    memcpy(out, start, length);
+    decoder->at = close;
+    while (decoder->at < decoder->end && *decoder->at != '"') {
+        const char *at = decoder->at;
+        if (*at != '\\') {
+            out = tableReserveStrings(decoder->out, length + 2);
+            out[length++] = *at;
+            decoder->at++;
+            continue;
+        }
+        if (decoder->end - at < 2) {
+            return 0;
+        }
+        out = tableReserveStrings(decoder->out, length + 5);
+        decoder->at += 2;
+        switch (at[1]) {
+            case '"': out[length++] = '"'; break;
+            case '\\': out[length++] = '\\'; break;
+            case '/': out[length++] = '/'; break;
+            case 'b': out[length++] = '\b'; break;
+            case 'f': out[length++] = '\f'; break;
+            case 'n': out[length++] = '\n'; break;
+            case 'r': out[length++] = '\r'; break;
+            case 't': out[length++] = '\t'; break;
+            default:
+                // \u escapes are rare enough to leave to cJSON
+                return 0;
+        }
+    }
+    if (decoder->at == decoder->end) {
+        return 0;
+    }
+    decoder->at++;
+    out[length] = '\0';
+    decoder->out->stringsLength += length + 1;
+    return 1;
+}
+
+// Reads an account number as an integer in [ACCOUNT_NUMBER_MIN, ACCOUNT_NUMBER_MAX]; anything else is left to cJSON
+int decodeAccountNumber(Decoder *decoder, int *accountNumber) {
+    const char *at = decoder->at;
+    unsigned long long number;
+    if (!decodeSequence(decoder, &number) || number < ACCOUNT_NUMBER_MIN || number > ACCOUNT_NUMBER_MAX) {
+        decoder->at = at;
+        return 0;
+    }
+    *accountNumber = (int) number;
+    return 1;
+}
+
+// Reads a journal sequence number as an integer, so it stays exact past 2^53
+int decodeSequence(Decoder *decoder, unsigned long long *number) {
+    char digits[64];
+    size_t length = decodeNumberText(decoder, digits, sizeof(digits));
+    char *after = NULL;
+    if (digits[0] < '0' || digits[0] > '9') {
+        return 0;
+    }
+    errno = 0;
+    *number = strtoull(digits, &after, 10);
+    if (errno != 0 || (size_t) (after - digits) != length) {
+        return 0;
+    }
+    decoder->at += length;
+    return 1;
+}
+
+int decodeAmount(Decoder *decoder, long long *amount) {
+    char digits[64];
+    size_t length = decodeNumberText(decoder, digits, sizeof(digits));
+    if (!parseAmount(digits, amount)) {
+        return 0;
+    }
+    decoder->at += length;
+    return 1;
+}
+
+// Copies the characters a number can be made of into digits, without consuming them
+size_t decodeNumberText(Decoder *decoder, char *digits, size_t size) {
+    size_t length = 0;
+    decodeSpace(decoder);
+    while (decoder->at + length < decoder->end && length < size - 1) {
+        char c = decoder->at[length];
+        if (!((c >= '0' && c <= '9') || c == '-' || c == '.' || c == 'e' || c == 'E' || c == '+')) {
+            break;
         }
+        digits[length++] = c;
+    }
+    digits[length] = '\0';
+    return length;
+}
+
+// Consumes byte (after whitespace) if it is next
+int decodeByte(Decoder *decoder, char byte) {
+    decodeSpace(decoder);
+    if (decoder->at < decoder->end && *decoder->at == byte) {
+        decoder->at++;
+        return 1;
     }
     return 0;
-}
\ No newline at end of file
+}
+
+void decodeSpace(Decoder *decoder) {
+    while (decoder->at < decoder->end && (unsigned char) *decoder->at <= ' ' && *decoder->at != '\0') {
+        decoder->at++;
+    }
+}
+
+// Adds an account whose string fields are given in AccountField order and returns its row
+size_t tableAdd(AccountTable *table, int accountNumber, long long balance, const char *const values[]) {
+    tableReserveRows(table, 1);
+    size_t row = table->count;
+    for (int field = 0; field < ACCOUNT_STRING_FIELDS; field++) {
+        table->fields[field][row] = tableAddString(table, values[field]);
+    }
+    table->accountNumbers[row] = accountNumber;
+    table->balances[row] = balance;
+    table->count++;
+    return row;
+}
+
+// Adds one account given as JSON text; returns its row, or NO_ROW if the text is not an account
+size_t tableAddRecord(AccountTable *table, const char *text, size_t length) {
+    Decoder decoder = { text, text + length, table };
+    size_t count = table->count;
+    size_t stringsLength = table->stringsLength;
+    if (decodeAccount(&decoder)) {
+        decodeSpace(&decoder);
+        if (decoder.at == decoder.end || *decoder.at == '\0') {
+            return count;
+        }
+    }
+    // Drop whatever the decoder stored before it gave up
+    table->count = count;
+    table->stringsLength = stringsLength;
+
+    cJSON *account = cJSON_ParseWithLength(text, length);
+    size_t row = tableAddJSON(table, account);
+    cJSON_Delete(account);
+    return row;
+}
+
+// Adds an account parsed by cJSON. Missing strings are stored empty and a missing balance as 0; an account number
+// that is not a whole number in [ACCOUNT_NUMBER_MIN, ACCOUNT_NUMBER_MAX] makes it fail.
+// cJSON has already turned the balance into a double, which is rounded to the nearest cent.
+size_t tableAddJSON(AccountTable *table, const cJSON *account) {
+    const cJSON *accountNumber = cJSON_GetObjectItem(account, KEY_ACCOUNT_NUMBER);
+    const cJSON *balance = cJSON_GetObjectItem(account, KEY_BALANCE);
+    long long cents = 0;
+    if (!cJSON_IsObject(account) || !cJSON_IsNumber(accountNumber) ||
+        !(accountNumber->valuedouble >= ACCOUNT_NUMBER_MIN && accountNumber->valuedouble <= ACCOUNT_NUMBER_MAX) ||
+        accountNumber->valuedouble != floor(accountNumber->valuedouble) ||
+        (cJSON_IsNumber(balance) && !amountFromDouble(balance->valuedouble, &cents))) {
+        return NO_ROW;
+    }
+
+    const char *values[ACCOUNT_STRING_FIELDS];
+    for (int field = 0; field < ACCOUNT_STRING_FIELDS; field++) {
+        const char *value = cJSON_GetStringValue(cJSON_GetObjectItem(account, ACCOUNT_STRING_KEYS[field]));
+        values[field] = value == NULL ? "" : value;
+    }
+    return tableAdd(table, (int) accountNumber->valuedouble, cents, values);
+}
+
+// cJSON keeps every number as a double; sequence numbers this program writes are integers well below 2^53
+unsigned long long sequenceValue(const cJSON *item) {
+    return item->valuedouble > 0 ? (unsigned long long) item->valuedouble : 0;
+}
+
+// Fills the table from a whole snapshot document parsed by cJSON
+int tableLoadJSON(AccountTable *table, const cJSON *json) {
+    const cJSON *accounts = cJSON_GetObjectItem(json, KEY_ACCOUNTS);
+    const cJSON *journalSeq = cJSON_GetObjectItem(json, KEY_JOURNAL_SEQ);
+    if (!cJSON_IsObject(json) || (accounts != NULL && !cJSON_IsArray(accounts))) {
+        return 0;
+    }
+    table->journalSeq = cJSON_IsNumber(journalSeq) ? sequenceValue(journalSeq) : 0;
+
+    const cJSON *account = NULL;
+    cJSON_ArrayForEach(account, accounts) {
+        if (tableAddJSON(table, account) == NO_ROW) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Moves all rows of rows to the end of table and empties rows
+void tableAppendTable(AccountTable *table, AccountTable *rows) {
+    if (rows->count == 0) {
+        tableFree(rows);
+        return;
+    }
+    if (table->count == 0 && table->stringsLength == 0) {
+        // Nothing to shift, take the columns over as they are
+        unsigned long long journalSeq = table->journalSeq;
+        tableFree(table);
+        *table = *rows;
+        table->journalSeq = journalSeq;
+        memset(rows, 0, sizeof(*rows));
+        return;
+    }
+
+    tableReserveRows(table, rows->count);
+    size_t base = table->stringsLength;
+    memcpy(tableReserveStrings(table, rows->stringsLength), rows->strings, rows->stringsLength);
+    table->stringsLength += rows->stringsLength;
+    table->stringsGarbage += rows->stringsGarbage;
+
+    memcpy(table->accountNumbers + table->count, rows->accountNumbers, rows->count * sizeof(int));
+    memcpy(table->balances + table->count, rows->balances, rows->count * sizeof(long long));
+    for (int field = 0; field < ACCOUNT_STRING_FIELDS; field++) {
+        for (size_t row = 0; row < rows->count; row++) {
+            table->fields[field][table->count + row] = rows->fields[field][row] + base;
+        }
+    }
+    table->count += rows->count;
+    tableFree(rows);
+}
+
+const char *tableString(const AccountTable *table, size_t row, AccountField field) {
+    return table->strings + table->fields[field][row];
+}
+
+void tableSetString(AccountTable *table, size_t row, AccountField field, const char *value) {
+    char *current = table->strings + table->fields[field][row];
+    size_t currentLength = strlen(current);
+    size_t length = strlen(value);
+
+    // A value that fits (a new pin of the same length) is overwritten in place
+    if (length <= currentLength) {
+        memcpy(current, value, length + 1);
+        table->stringsGarbage += currentLength - length;
+        return;
+    }
+    table->stringsGarbage += currentLength + 1;
+    table->fields[field][row] = tableAddString(table, value);
+    if (table->stringsGarbage >= TABLE_COMPACT_MIN_BYTES && table->stringsGarbage > table->stringsLength / 2) {
+        tableCompact(table);
+    }
+}
+
+// Deletes a row by moving the last row into its place
+void tableRemove(AccountTable *table, size_t row) {
+    for (int field = 0; field < ACCOUNT_STRING_FIELDS; field++) {
+        table->stringsGarbage += strlen(tableString(table, row, field)) + 1;
+    }
+    indexRemove(table->accountNumbers[row]);
+
+    size_t last = --table->count;
+    if (row != last) {
+        table->accountNumbers[row] = table->accountNumbers[last];
+        table->balances[row] = table->balances[last];
+        for (int field = 0; field < ACCOUNT_STRING_FIELDS; field++) {
+            table->fields[field][row] = table->fields[field][last];
+        }
+        indexInsert(table->accountNumbers[row], row);
+    }
+
+    if (table->stringsGarbage >= TABLE_COMPACT_MIN_BYTES && table->stringsGarbage > table->stringsLength / 2) {
+        tableCompact(table);
+    }
+}
+
+// Copies the live strings into a fresh heap, leaving out replaced and deleted ones
+void tableCompact(AccountTable *table) {
+    size_t capacity = table->stringsLength - table->stringsGarbage;
+    char *strings = malloc(capacity == 0 ? 1 : capacity);
+    if (strings == NULL) {
+        perror("Error allocating memory. Function tableCompact()");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t length = 0;
+    for (size_t row = 0; row < table->count; row++) {
+        for (int field = 0; field < ACCOUNT_STRING_FIELDS; field++) {
+            const char *value = tableString(table, row, field);
+            size_t size = strlen(value) + 1;
+            memcpy(strings + length, value, size);
+            table->fields[field][row] = length;
+            length += size;
+        }
+    }
+
+    free(table->strings);
+    table->strings = strings;
+    table->stringsLength = length;
+    table->stringsCapacity = capacity == 0 ? 1 : capacity;
+    table->stringsGarbage = 0;
+}
+
+// Makes room for rows more rows in every column
+void tableReserveRows(AccountTable *table, size_t rows) {
+    if (table->count + rows <= table->capacity) {
+        return;
+    }
+    size_t capacity = table->capacity == 0 ? 1024 : table->capacity;
+    while (capacity < table->count + rows) {
+        capacity *= 2;
+    }
+
+    table->accountNumbers = realloc(table->accountNumbers, capacity * sizeof(int));
+    table->balances = realloc(table->balances, capacity * sizeof(long long));
+    int failed = table->accountNumbers == NULL || table->balances == NULL;
+    for (int field = 0; field < ACCOUNT_STRING_FIELDS; field++) {
+        table->fields[field] = realloc(table->fields[field], capacity * sizeof(size_t));
+        failed |= table->fields[field] == NULL;
+    }
+    if (failed) {
+        perror("Error allocating memory. Function tableReserveRows()");
+        exit(EXIT_FAILURE);
+    }
+    table->capacity = capacity;
+}
+
+// Copies value to the end of the string heap and returns its offset
+size_t tableAddString(AccountTable *table, const char *value) {
+    size_t size = strlen(value) + 1;
+    size_t offset = table->stringsLength;
+    memcpy(tableReserveStrings(table, size), value, size);
+    table->stringsLength += size;
+    return offset;
+}
+
+// Makes room for bytes more bytes after the current end of the string heap and returns that end
+char *tableReserveStrings(AccountTable *table, size_t bytes) {
+    if (table->stringsLength + bytes > table->stringsCapacity) {
+        size_t capacity = table->stringsCapacity == 0 ? 64 * 1024 : table->stringsCapacity;
+        while (capacity < table->stringsLength + bytes) {
+            capacity *= 2;
+        }
+        char *grown = realloc(table->strings, capacity);
+        if (grown == NULL) {
+            perror("Error allocating memory. Function tableReserveStrings()");
+            exit(EXIT_FAILURE);
+        }
+        table->strings = grown;
+        table->stringsCapacity = capacity;
+    }
+    return table->strings + table->stringsLength;
+}
+
+void tableFree(AccountTable *table) {
+    free(table->accountNumbers);
+    free(table->balances);
+    for (int field = 0; field < ACCOUNT_STRING_FIELDS; field++) {
+        free(table->fields[field]);
+    }
+    free(table->strings);
+    memset(table, 0, sizeof(*table));
+}
+
+void encoderInit() {
+    const char *keys[ACCOUNT_STRING_FIELDS + 2];
+    memcpy(keys, ACCOUNT_STRING_KEYS, sizeof(ACCOUNT_STRING_KEYS));
+    keys[ACCOUNT_STRING_FIELDS] = KEY_ACCOUNT_NUMBER;
+    keys[ACCOUNT_STRING_FIELDS + 1] = KEY_BALANCE;
+
+    for (int pretty = 0; pretty <= 1; pretty++) {
+        AccountLayout *layout = &accountLayouts[pretty];
+        // Accounts sit at depth 3 (document, accounts array, account) when pretty-printed
+        strcpy(layout->open, pretty ? "{\n" : "{");
+        strcpy(layout->close, pretty ? "\n\t\t}" : "}");
+        strcpy(layout->separator, pretty ? ", " : ",");
+        for (int field = 0; field < ACCOUNT_STRING_FIELDS + 2; field++) {
+            char *fragment = layout->keys[field];
+            size_t length = 0;
+            if (field > 0) {
+                length += (size_t) sprintf(fragment, pretty ? ",\n" : ",");
+            }
+            if (pretty) {
+                length += (size_t) sprintf(fragment + length, "\t\t\t");
+            }
+            length += cJSON_PrintStringValue(keys[field], fragment + length, sizeof(layout->keys[field]) - length - 3);
+            layout->keyLengths[field] = length + (size_t) sprintf(fragment + length, pretty ? ":\t" : ":");
+        }
+        layout->openLength = strlen(layout->open);
+        layout->closeLength = strlen(layout->close);
+        layout->separatorLength = strlen(layout->separator);
+    }
+}
+
+/* Encodes the accounts in rounds of one range per core and writes the ranges in order. The range buffers are kept
+   from one save to the next, so once they have grown to fit a range a save allocates nothing. */
+void encodeAccounts(const AccountTable *table, int pretty, int lines, SnapshotWriter *writer) {
+    static EncodeRange ranges[PARALLEL_MAX_THREADS]; // Only one save runs at a time
+    size_t cores = coreCount();
+
+    size_t row = 0;
+    while (row < table->count) {
+        size_t count = 0;
+        for (; count < cores && row < table->count; count++) {
+            ranges[count].table = table;
+            ranges[count].first = row;
+            ranges[count].count = table->count - row < ENCODE_RANGE_ACCOUNTS ? table->count - row : ENCODE_RANGE_ACCOUNTS;
+            ranges[count].pretty = pretty;
+            ranges[count].lines = lines;
+            row += ranges[count].count;
+        }
+        runParallel(encodeRange, ranges, sizeof(EncodeRange), count);
+        for (size_t i = 0; i < count; i++) {
+            snapshotWrite(writer, ranges[i].out.data, ranges[i].out.length);
+        }
+    }
+}
+
+void *encodeRange(void *arg) {
+    EncodeRange *range = arg;
+    const AccountLayout *layout = &accountLayouts[range->pretty];
+    range->out.length = 0;
+    for (size_t row = range->first; row < range->first + range->count; row++) {
+        encodeAccount(range->table, row, layout, &range->out);
+        if (range->lines) {
+            encodeText(&range->out, "\n", 1);
+        } else if (row + 1 < range->table->count) {
+            encodeText(&range->out, layout->separator, layout->separatorLength);
+        }
+    }
+    return NULL;
+}
+
+void encodeAccount(const AccountTable *table, size_t row, const AccountLayout *layout, EncodeBuffer *out) {
+    encodeText(out, layout->open, layout->openLength);
+    for (int field = 0; field < ACCOUNT_STRING_FIELDS; field++) {
+        encodeText(out, layout->keys[field], layout->keyLengths[field]);
+
+        // Almost every value is plain text that goes out between quotes as is
+        const unsigned char *value = (const unsigned char *) tableString(table, row, field);
+        size_t length = 0;
+        while (value[length] >= ' ' && value[length] != '"' && value[length] != '\\') {
+            length++;
+        }
+        if (value[length] == '\0') {
+            char *text = encodeReserve(out, length + 2);
+            text[0] = '"';
+            memcpy(text + 1, value, length);
+            text[length + 1] = '"';
+            out->length += length + 2;
+            continue;
+        }
+        size_t room = (length + strlen((const char *) value + length)) * 6 + 3; // Every byte as \u00XX
+        out->length += cJSON_PrintStringValue((const char *) value, encodeReserve(out, room), room);
+    }
+    encodeText(out, layout->keys[ACCOUNT_STRING_FIELDS], layout->keyLengths[ACCOUNT_STRING_FIELDS]);
+    out->length += cJSON_PrintNumberValue(table->accountNumbers[row], encodeReserve(out, 32), 32);
+    encodeText(out, layout->keys[ACCOUNT_STRING_FIELDS + 1], layout->keyLengths[ACCOUNT_STRING_FIELDS + 1]);
+    out->length += formatAmount(table->balances[row], encodeReserve(out, AMOUNT_LENGTH), 0);
+    encodeText(out, layout->close, layout->closeLength);
+}
+
+void encodeText(EncodeBuffer *out, const char *text, size_t length) {
+    memcpy(encodeReserve(out, length), text, length);
+    out->length += length;
+}
+
+// Makes room for bytes more bytes and returns the end of the buffer
+char *encodeReserve(EncodeBuffer *out, size_t bytes) {
+    if (out->length + bytes > out->capacity) {
+        size_t capacity = out->capacity == 0 ? 64 * 1024 : out->capacity;
+        while (capacity < out->length + bytes) {
+            capacity *= 2;
+        }
+        char *grown = realloc(out->data, capacity);
+        if (grown == NULL) {
+            perror("Error allocating memory. Function encodeReserve()");
+            exit(EXIT_FAILURE);
+        }
+        out->data = grown;
+        out->capacity = capacity;
+    }
+    return out->data + out->length;
+}
+
+size_t parallelism(size_t bytes) {
+    size_t count = bytes / PARALLEL_MIN_BYTES;
+    if (count > coreCount()) {
+        count = coreCount();
+    }
+    return count == 0 ? 1 : count;
+}
+
+size_t coreCount() {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) {
+        return 1;
+    }
+    return cores > PARALLEL_MAX_THREADS ? PARALLEL_MAX_THREADS : (size_t) cores;
+}
+
+void runParallel(void *(*task)(void *), void *tasks, size_t taskSize, size_t count) {
+    // Task 0 runs on the calling thread; every other task gets its own thread. The pool allocator is per thread.
+    pthread_t threads[PARALLEL_MAX_THREADS];
+    size_t started = 1;
+    for (; started < count; started++) {
+        if (pthread_create(&threads[started], NULL, task, (char *) tasks + started * taskSize) != 0) {
+            perror("Error starting thread. Function runParallel()");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (count > 0) {
+        task(tasks);
+    }
+    for (size_t i = 1; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+void parseArguments(int argc, char *argv[]) {
+    int valid = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format=pretty") == 0) {
+            storageFormat = FORMAT_PRETTY;
+        } else if (strcmp(argv[i], "--format=compact") == 0) {
+            storageFormat = FORMAT_COMPACT;
+        } else if (strcmp(argv[i], "--format=jsonl") == 0) {
+            storageFormat = FORMAT_JSONL;
+        } else if (strncmp(argv[i], "--batch=", 8) == 0 && argv[i][8] != '\0') {
+            batchFile = argv[i] + 8;
+        } else if (strncmp(argv[i], "--out=", 6) == 0 && argv[i][6] != '\0') {
+            batchOutFile = argv[i] + 6;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = 1;
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            char *end = NULL;
+            long threads = strtol(argv[i] + 10, &end, 10);
+            if (end == argv[i] + 10 || *end != '\0' || threads < 1 || threads > PARALLEL_MAX_THREADS) {
+                valid = 0;
+                break;
+            }
+            batchThreads = (size_t) threads;
+        } else {
+            valid = 0;
+            break;
+        }
+    }
+    // --batch and --out only make sense together
+    if (!valid || (batchFile == NULL) != (batchOutFile == NULL)) {
+        fprintf(stderr, "Usage: %s [--format=pretty|compact|jsonl] [--verbose] "
+                "[--batch=ops.txt --out=results.txt [--threads=N]]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*
+   Parses a decimal amount of money ("12", "-0.5", "10.25") into cents without going through a double. Digits past
+   the second decimal round half away from zero, so values written by older versions as doubles ("3235.1199999999999",
+   "1e-07") come back as the nearest cent. Returns 0 for anything that is not a number or does not fit.
+*/
+int parseAmount(const char *text, long long *amount) {
+    const char *at = text;
+    int negative = *at == '-';
+    if (*at == '-' || *at == '+') {
+        at++;
+    }
+
+    long long units = 0;
+    int digits = 0;
+    for (; *at >= '0' && *at <= '9'; at++, digits++) {
+        if (units > (LLONG_MAX / MINOR_UNITS - 1) / 10) {
+            return 0;
+        }
+        units = units * 10 + (*at - '0');
+    }
+    long long cents = 0;
+    int decimals = 0;
+    int roundUp = 0;
+    if (*at == '.') {
+        for (at++; *at >= '0' && *at <= '9'; at++, digits++, decimals++) {
+            if (decimals < 2) {
+                cents = cents * 10 + (*at - '0');
+            } else if (decimals == 2) {
+                roundUp = *at >= '5';
+            }
+        }
+    }
+    if (digits == 0) {
+        return 0;
+    }
+    if (*at == 'e' || *at == 'E') {
+        // Only doubles printed by older versions have an exponent
+        char *end = NULL;
+        double value = strtod(text, &end);
+        return *end == '\0' && amountFromDouble(value, amount);
+    }
+    if (*at != '\0') {
+        return 0;
+    }
+
+    for (; decimals < 2; decimals++) {
+        cents *= 10;
+    }
+    long long total = units * MINOR_UNITS + cents + roundUp;
+    *amount = negative ? -total : total;
+    return 1;
+}
+
+// Reads one amount typed by the user
+int readAmount(long long *amount) {
+    char text[AMOUNT_LENGTH];
+    if (scanf("%31s", text) != 1) {
+        return 0;
+    }
+    return parseAmount(text, amount);
+}
+
+// Reads one account number typed by the user; anything else typed is consumed too, so it is not read again
+int readAccountNumber(int *accountNumber) {
+    char text[AMOUNT_LENGTH];
+    if (scanf("%31s", text) != 1) {
+        return 0;
+    }
+    char *end = NULL;
+    long number = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || number <= 0 || number > INT_MAX) {
+        return 0;
+    }
+    *accountNumber = (int) number;
+    return 1;
+}
+
+// Adds an amount (negative to take it away) to a balance; fails instead of overflowing
+int addAmount(long long balance, long long amount, long long *result) {
+    return !__builtin_add_overflow(balance, amount, result);
+}
+
+// Rounds a double amount to the nearest cent; fails if it is out of range (or not a number)
+int amountFromDouble(double value, long long *amount) {
+    double cents = value * MINOR_UNITS;
+    if (!(fabs(cents) < (double) LLONG_MAX)) {
+        return 0;
+    }
+    *amount = (long long) (cents < 0 ? cents - 0.5 : cents + 0.5);
+    return 1;
+}
+
+/*
+   Writes an amount in cents as a decimal number: with no trailing zeros ("505.2", "500") for files, which is also
+   how cJSON prints the same value as a double, or with both decimals ("505.20") for display. Returns the length.
+*/
+size_t formatAmount(long long amount, char *buffer, int bothDecimals) {
+    unsigned long long magnitude = amount < 0 ? 0 - (unsigned long long) amount : (unsigned long long) amount;
+    unsigned int cents = (unsigned int) (magnitude % MINOR_UNITS);
+    unsigned long long units = magnitude / MINOR_UNITS;
+    char digits[AMOUNT_LENGTH];
+    size_t count = 0;
+
+    // Built backwards from the last decimal
+    if (bothDecimals || cents != 0) {
+        if (bothDecimals || cents % 10 != 0) {
+            digits[count++] = (char) ('0' + cents % 10);
+        }
+        digits[count++] = (char) ('0' + cents / 10);
+        digits[count++] = '.';
+    }
+    do {
+        digits[count++] = (char) ('0' + units % 10);
+        units /= 10;
+    } while (units != 0);
+
+    size_t length = 0;
+    if (amount < 0) {
+        buffer[length++] = '-';
+    }
+    while (count > 0) {
+        buffer[length++] = digits[--count];
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+void runBatch(AccountTable *table, const char *opsFile, const char *resultsFile) {
+    struct timespec start, applyStart, applied, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    FILE *file = fopen(opsFile, "r");
+    if (file == NULL) {
+        perror("Error opening batch file. Function runBatch()");
+        exit(EXIT_FAILURE);
+    }
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *buffer = malloc((size_t) fileSize + 1);
+    if (buffer == NULL) {
+        perror("Error allocating memory. Function runBatch()");
+        fclose(file);
+        exit(EXIT_FAILURE);
+    }
+    size_t bytesRead = fread(buffer, 1, (size_t) fileSize, file);
+    buffer[bytesRead] = '\0';
+    fclose(file);
+
+    // Split the file into operations up front, so workers only ever parse their own lines
+    BatchQueue queue = { .table = table, .lock = PTHREAD_MUTEX_INITIALIZER };
+    size_t capacity = 0;
+    size_t lineNumber = 0;
+    size_t creations = 0;
+    for (char *line = buffer; line < buffer + bytesRead; ) {
+        char *lineEnd = memchr(line, '\n', (size_t) (buffer + bytesRead - line));
+        if (lineEnd == NULL) {
+            lineEnd = buffer + bytesRead;
+        }
+        *lineEnd = '\0';
+        if (lineEnd > line && lineEnd[-1] == '\r') {
+            lineEnd[-1] = '\0';
+        }
+        lineNumber++;
+
+        char *first = line + strspn(line, " \t");
+        if (*first != '\0' && *first != '#') {
+            if (queue.count == capacity) {
+                capacity = capacity == 0 ? 1024 : capacity * 2;
+                queue.ops = realloc(queue.ops, capacity * sizeof(BatchOp));
+                if (queue.ops == NULL) {
+                    perror("Error allocating memory. Function runBatch()");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            queue.ops[queue.count++] = (BatchOp) { .line = first, .lineNumber = lineNumber };
+            if (first[0] == 'C' && (first[1] == ' ' || first[1] == '\t')) {
+                creations++;
+            }
+        }
+        line = lineEnd + 1;
+    }
+
+    // Account numbers for all creations are reserved in one block, so workers never draw them one by one
+    int *numbers = malloc((creations == 0 ? 1 : creations) * sizeof(int));
+    if (numbers == NULL) {
+        perror("Error allocating memory. Function runBatch()");
+        exit(EXIT_FAILURE);
+    }
+    size_t reserved = reserveAccountNumbers(numbers, creations);
+    for (size_t i = 0, next = 0; i < queue.count && next < reserved; i++) {
+        const char *first = queue.ops[i].line;
+        if (first[0] == 'C' && (first[1] == ' ' || first[1] == '\t')) {
+            queue.ops[i].reservedNumber = numbers[next++];
+        }
+    }
+    free(numbers);
+
+    for (size_t i = 0; i < ACCOUNT_LOCK_STRIPES; i++) {
+        pthread_mutex_init(&accountLocks[i].lock, NULL);
+    }
+    BatchQueue *workers[PARALLEL_MAX_THREADS];
+    for (size_t i = 0; i < batchThreads; i++) {
+        workers[i] = &queue;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &applyStart);
+    runParallel(batchWorkerRun, workers, sizeof(BatchQueue *), batchThreads);
+    clock_gettime(CLOCK_MONOTONIC, &applied);
+
+    // Numbers reserved for creations that were refused go back to the free set
+    for (size_t i = 0; i < queue.count; i++) {
+        if (queue.ops[i].reservedNumber != 0 && queue.ops[i].error != NULL) {
+            accountNumbersRelease(queue.ops[i].reservedNumber);
+        }
+    }
+
+    // Results are collected in memory and only written once the snapshot holding the batch is on disk
+    EncodeBuffer results = { 0 };
+    size_t failed = 0;
+    for (size_t i = 0; i < queue.count; i++) {
+        const BatchOp *op = &queue.ops[i];
+        char result[128];
+        int length;
+        if (op->error == NULL) {
+            char balance[AMOUNT_LENGTH];
+            formatAmount(op->balance, balance, 0);
+            length = snprintf(result, sizeof(result), "%zu OK %d %s\n", op->lineNumber, op->accountNumber, balance);
+        } else {
+            length = snprintf(result, sizeof(result), "%zu ERROR %s\n", op->lineNumber, op->error);
+            failed++;
+        }
+        encodeText(&results, result, (size_t) length);
+    }
+    free(queue.ops);
+    free(buffer);
+
+    checkpoint(table);
+
+    int fd = open(resultsFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("Error opening results file. Function runBatch()");
+        exit(EXIT_FAILURE);
+    }
+    writeAll(fd, results.data, results.length);
+    if (close(fd) != 0) {
+        perror("Error writing results file. Function runBatch()");
+        exit(EXIT_FAILURE);
+    }
+    free(results.data);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double appliedMs = (double) (applied.tv_sec - applyStart.tv_sec) * 1000.0 +
+                       (double) (applied.tv_nsec - applyStart.tv_nsec) / 1e6;
+    fprintf(stderr, "Batch: %zu operations, %zu failed, in %.1f ms (%.1f ms to apply on %zu threads)\n", queue.count,
+            failed, (double) (end.tv_sec - start.tv_sec) * 1000.0 + (double) (end.tv_nsec - start.tv_nsec) / 1e6,
+            appliedMs, batchThreads);
+}
+
+void *batchWorkerRun(void *arg) {
+    BatchQueue *queue = *(BatchQueue **) arg;
+    for (;;) {
+        pthread_mutex_lock(&queue->lock);
+        size_t first = queue->next;
+        size_t last = queue->count - first < BATCH_CLAIM_OPS ? queue->count : first + BATCH_CLAIM_OPS;
+        queue->next = last;
+        pthread_mutex_unlock(&queue->lock);
+        if (first == last) {
+            return NULL;
+        }
+
+        for (size_t i = first; i < last; i++) {
+            queue->ops[i].error = batchApply(queue->table, &queue->ops[i]);
+        }
+    }
+}
+
+// Applies one operation; returns NULL and fills in the result account and balance, or returns why it was rejected
+const char *batchApply(AccountTable *table, BatchOp *op) {
+    char *at = op->line;
+    const char *code = batchField(&at);
+    if (strlen(code) != 1 || strchr("DWTPC", *code) == NULL) {
+        return "unknown operation";
+    }
+
+    if (*code == 'C') {
+        const char *values[ACCOUNT_STRING_FIELDS];
+        for (int field = FIELD_NAME; field <= FIELD_PIN; field++) {
+            values[field] = batchField(&at);
+        }
+        const char *balanceText = batchField(&at);
+        if (balanceText == NULL) {
+            return "missing fields";
+        }
+        long long balance;
+        if (!parseAmount(balanceText, &balance) || balance < 0) {
+            return "invalid amount";
+        }
+        if (strlen(values[FIELD_PIN]) >= MAX_PIN_LENGTH) {
+            return "invalid pin";
+        }
+        // The question and answer are the rest of the line, split at the first |
+        at += strspn(at, " \t");
+        char *separator = strchr(at, '|');
+        if (separator == NULL) {
+            return "missing fields";
+        }
+        *separator = '\0';
+        values[FIELD_SECURITY_QUESTION] = at;
+        values[FIELD_SECURITY_ANSWER] = separator + 1;
+        for (int field = 0; field < ACCOUNT_STRING_FIELDS; field++) {
+            if (strlen(values[field]) >= ACCOUNT_STRING_SIZES[field]) {
+                return "invalid field";
+            }
+        }
+
+        if (op->reservedNumber == 0) {
+            return "no account numbers left";
+        }
+
+        pthread_rwlock_wrlock(&tableLock);
+        indexInsert(op->reservedNumber, tableAdd(table, op->reservedNumber, balance, values));
+        pthread_rwlock_unlock(&tableLock);
+        op->accountNumber = op->reservedNumber;
+        op->balance = balance;
+        return NULL;
+    }
+
+    const char *accountText = batchField(&at);
+    const char *toAccountText = *code == 'T' ? batchField(&at) : NULL;
+    const char *value = batchField(&at);
+    if (value == NULL) {
+        return "missing fields";
+    }
+    if (batchField(&at) != NULL) {
+        return "too many fields";
+    }
+
+    // A pin change may grow the string heap; balance changes only need their own accounts locked
+    if (*code == 'P') {
+        pthread_rwlock_wrlock(&tableLock);
+    } else {
+        pthread_rwlock_rdlock(&tableLock);
+    }
+    const char *error = batchUpdate(table, *code, accountText, toAccountText, value, op);
+    pthread_rwlock_unlock(&tableLock);
+    return error;
+}
+
+// Applies a D, W, T or P operation to an existing account; the caller holds tableLock
+const char *batchUpdate(AccountTable *table, char op, const char *accountText, const char *toAccountText,
+                        const char *value, BatchOp *result) {
+    size_t row = batchAccount(accountText);
+    if (row == NO_ROW) {
+        return "no such account";
+    }
+    int accountNumber = table->accountNumbers[row];
+    result->accountNumber = accountNumber;
+
+    switch (op) {
+        case 'D':
+        case 'W': {
+            long long amount;
+            if (!parseAmount(value, &amount) || amount <= 0) {
+                return "invalid amount";
+            }
+            lockAccounts(accountNumber, accountNumber);
+            if (op == 'W' && table->balances[row] < amount) {
+                unlockAccounts(accountNumber, accountNumber);
+                return "insufficient balance";
+            }
+            long long balance;
+            if (!addAmount(table->balances[row], op == 'D' ? amount : -amount, &balance)) {
+                unlockAccounts(accountNumber, accountNumber);
+                return "invalid amount";
+            }
+            table->balances[row] = balance;
+            result->balance = balance;
+            unlockAccounts(accountNumber, accountNumber);
+            return NULL;
+        }
+        case 'T': {
+            size_t toRow = batchAccount(toAccountText);
+            long long amount;
+            if (toRow == NO_ROW) {
+                return "no such recipient account";
+            }
+            if (toRow == row) {
+                return "same account";
+            }
+            if (!parseAmount(value, &amount) || amount <= 0) {
+                return "invalid amount";
+            }
+            int toAccountNumber = table->accountNumbers[toRow];
+            lockAccounts(accountNumber, toAccountNumber);
+            if (table->balances[row] < amount) {
+                unlockAccounts(accountNumber, toAccountNumber);
+                return "insufficient balance";
+            }
+            long long toBalance;
+            if (!addAmount(table->balances[toRow], amount, &toBalance)) {
+                unlockAccounts(accountNumber, toAccountNumber);
+                return "invalid amount";
+            }
+            table->balances[row] -= amount;
+            table->balances[toRow] = toBalance;
+            result->balance = table->balances[row];
+            unlockAccounts(accountNumber, toAccountNumber);
+            return NULL;
+        }
+        case 'P':
+            if (strlen(value) >= MAX_PIN_LENGTH) {
+                return "invalid pin";
+            }
+            tableSetString(table, row, FIELD_PIN, value);
+            result->balance = table->balances[row];
+            return NULL;
+        default:
+            return "unknown operation";
+    }
+}
+
+// Locks the stripes of one or two accounts, the lower stripe first; pass the same account twice to lock one
+void lockAccounts(int accountNumber, int otherAccountNumber) {
+    size_t stripe = (size_t) accountNumber % ACCOUNT_LOCK_STRIPES;
+    size_t otherStripe = (size_t) otherAccountNumber % ACCOUNT_LOCK_STRIPES;
+    if (stripe > otherStripe) {
+        size_t swap = stripe;
+        stripe = otherStripe;
+        otherStripe = swap;
+    }
+    pthread_mutex_lock(&accountLocks[stripe].lock);
+    if (otherStripe != stripe) {
+        pthread_mutex_lock(&accountLocks[otherStripe].lock);
+    }
+}
+
+void unlockAccounts(int accountNumber, int otherAccountNumber) {
+    size_t stripe = (size_t) accountNumber % ACCOUNT_LOCK_STRIPES;
+    size_t otherStripe = (size_t) otherAccountNumber % ACCOUNT_LOCK_STRIPES;
+    if (otherStripe != stripe) {
+        pthread_mutex_unlock(&accountLocks[otherStripe].lock);
+    }
+    pthread_mutex_unlock(&accountLocks[stripe].lock);
+}
+
+// Finds the row of an account number given as text, NO_ROW if it is not a number or not an account
+size_t batchAccount(const char *text) {
+    char *end = NULL;
+    long accountNumber = strtol(text, &end, 10);
+    if (*end != '\0' || accountNumber <= 0 || accountNumber > INT_MAX) {
+        return NO_ROW;
+    }
+    return indexFind((int) accountNumber);
+}
+
+// Cuts the next space-separated field out of the line; NULL at the end of the line
+char *batchField(char **at) {
+    char *field = *at + strspn(*at, " \t");
+    if (*field == '\0') {
+        *at = field;
+        return NULL;
+    }
+    char *fieldEnd = field + strcspn(field, " \t");
+    *at = *fieldEnd == '\0' ? fieldEnd : fieldEnd + 1;
+    *fieldEnd = '\0';
+    return field;
+}
+
+void journalOpen(const char *filename) {
+    journal.fd = open(filename, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (journal.fd < 0) {
+        perror("Error opening journal. Function journalOpen()");
+        exit(EXIT_FAILURE);
+    }
+    // The file may be new (and after a rotation the old one renamed); records fsynced into it only count once its
+    // directory entry is on disk too
+    syncDirectory();
+    journal.bytes = (size_t) lseek(journal.fd, 0, SEEK_END);
+}
+
+void journalStart() {
+    journal.durableSeq = journal.nextSeq - 1;
+    if (pthread_create(&journal.flusher, NULL, journalFlusherRun, NULL) != 0) {
+        perror("Error starting journal flusher. Function journalStart()");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void journalClose() {
+    pthread_mutex_lock(&journal.lock);
+    journal.stop = 1;
+    pthread_cond_signal(&journal.flushWake);
+    pthread_mutex_unlock(&journal.lock);
+    pthread_join(journal.flusher, NULL);
+
+    close(journal.fd);
+    free(journal.pending);
+    if (verbose) {
+        fprintf(stderr, "Journal: %llu records in %llu fsyncs (%.1f records per fsync)\n",
+                journal.committedOps, journal.fsyncs,
+                journal.fsyncs == 0 ? 0.0 : (double) journal.committedOps / (double) journal.fsyncs);
+    }
+}
+
+unsigned long long journalAppend(const char *record, size_t length, unsigned long long seq) {
+    pthread_mutex_lock(&journal.lock);
+    if (journal.pendingLength + length > journal.pendingCapacity) {
+        size_t capacity = journal.pendingCapacity == 0 ? 4096 : journal.pendingCapacity;
+        while (capacity < journal.pendingLength + length) {
+            capacity *= 2;
+        }
+        char *pending = realloc(journal.pending, capacity);
+        if (pending == NULL) {
+            perror("Error allocating memory. Function journalAppend()");
+            exit(EXIT_FAILURE);
+        }
+        journal.pending = pending;
+        journal.pendingCapacity = capacity;
+    }
+    memcpy(journal.pending + journal.pendingLength, record, length);
+    journal.pendingLength += length;
+    journal.pendingLastSeq = seq;
+    journal.bytes += length;
+
+    // The first record of a batch opens the commit window, a full batch closes it early
+    if (++journal.pendingOps == 1) {
+        clock_gettime(CLOCK_REALTIME, &journal.pendingSince);
+        pthread_cond_signal(&journal.flushWake);
+    } else if (journal.pendingOps >= GROUP_COMMIT_MAX_OPS) {
+        pthread_cond_signal(&journal.flushWake);
+    }
+    pthread_mutex_unlock(&journal.lock);
+
+    if (journal.bytes >= CHECKPOINT_JOURNAL_BYTES) {
+        pthread_cond_signal(&checkpointer.wake);
+    }
+    return seq;
+}
+
+void journalFlushLocked() {
+    while (journal.flushing) {
+        pthread_cond_wait(&journal.durable, &journal.lock);
+    }
+    if (journal.pendingOps == 0) {
+        return;
+    }
+
+    // Take the batch and let new records collect in a fresh buffer while this one is written
+    char *batch = journal.pending;
+    size_t length = journal.pendingLength;
+    size_t ops = journal.pendingOps;
+    unsigned long long lastSeq = journal.pendingLastSeq;
+    journal.pending = NULL;
+    journal.pendingLength = 0;
+    journal.pendingCapacity = 0;
+    journal.pendingOps = 0;
+    journal.flushing = 1;
+    pthread_mutex_unlock(&journal.lock);
+
+    writeAll(journal.fd, batch, length);
+    if (fdatasync(journal.fd) != 0) {
+        perror("Error flushing journal. Function journalFlushLocked()");
+        exit(EXIT_FAILURE);
+    }
+    free(batch);
+
+    pthread_mutex_lock(&journal.lock);
+    journal.flushing = 0;
+    journal.durableSeq = lastSeq;
+    journal.fsyncs++;
+    journal.committedOps += ops;
+    pthread_cond_broadcast(&journal.durable);
+}
+
+void journalCommit(unsigned long long seq) {
+    pthread_mutex_lock(&journal.lock);
+    while (journal.durableSeq < seq) {
+        pthread_cond_wait(&journal.durable, &journal.lock);
+    }
+    pthread_mutex_unlock(&journal.lock);
+}
+
+void *journalFlusherRun(void *arg) {
+    pthread_mutex_lock(&journal.lock);
+    for (;;) {
+        while (journal.pendingOps == 0 && !journal.stop) {
+            pthread_cond_wait(&journal.flushWake, &journal.lock);
+        }
+        if (journal.pendingOps == 0) {
+            break; // Stopping with nothing left to write
+        }
+
+        // Hold the batch open for the commit window so concurrent writers can share its fsync
+        struct timespec deadline = journal.pendingSince;
+        deadline.tv_nsec += GROUP_COMMIT_WINDOW_MICROSECONDS * 1000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+        while (journal.pendingOps > 0 && journal.pendingOps < GROUP_COMMIT_MAX_OPS && !journal.stop) {
+            if (pthread_cond_timedwait(&journal.flushWake, &journal.lock, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+        journalFlushLocked();
+    }
+    pthread_mutex_unlock(&journal.lock);
+
+    return arg;
+}
+
+unsigned long long journalBalance(char op, int accountNumber, long long amount, long long balance) {
+    char record[128];
+    char amountText[AMOUNT_LENGTH];
+    char balanceText[AMOUNT_LENGTH];
+    unsigned long long seq = journal.nextSeq++;
+    formatAmount(amount, amountText, 0);
+    formatAmount(balance, balanceText, 0);
+    int length = snprintf(record, sizeof(record), "%llu %c %d %s %s\n", seq, op, accountNumber, amountText, balanceText);
+    return journalAppend(record, (size_t) length, seq);
+}
+
+unsigned long long journalTransfer(int accountNumber, int toAccountNumber, long long amount, long long balance,
+                                   long long toBalance) {
+    char record[160];
+    char amountText[AMOUNT_LENGTH];
+    char balanceText[AMOUNT_LENGTH];
+    char toBalanceText[AMOUNT_LENGTH];
+    unsigned long long seq = journal.nextSeq++;
+    formatAmount(amount, amountText, 0);
+    formatAmount(balance, balanceText, 0);
+    formatAmount(toBalance, toBalanceText, 0);
+    int length = snprintf(record, sizeof(record), "%llu T %d %d %s %s %s\n", seq, accountNumber, toAccountNumber,
+                          amountText, balanceText, toBalanceText);
+    return journalAppend(record, (size_t) length, seq);
+}
+
+unsigned long long journalPin(int accountNumber, const char *pin) {
+    char record[128];
+    unsigned long long seq = journal.nextSeq++;
+    int length = snprintf(record, sizeof(record), "%llu P %d %s\n", seq, accountNumber, pin);
+    return journalAppend(record, (size_t) length, seq);
+}
+
+unsigned long long journalCreate(const AccountTable *table, size_t row) {
+    char prefix[64];
+    unsigned long long seq = journal.nextSeq++;
+    int length = snprintf(prefix, sizeof(prefix), "%llu C %d ", seq, table->accountNumbers[row]);
+
+    // The account goes in as the same compact JSON the snapshot holds
+    EncodeBuffer record = { 0 };
+    encodeText(&record, prefix, (size_t) length);
+    encodeAccount(table, row, &accountLayouts[0], &record);
+    encodeText(&record, "\n", 1);
+    journalAppend(record.data, record.length, seq);
+
+    free(record.data);
+    return seq;
+}
+
+unsigned long long journalDelete(int accountNumber) {
+    char record[64];
+    unsigned long long seq = journal.nextSeq++;
+    int length = snprintf(record, sizeof(record), "%llu X %d\n", seq, accountNumber);
+    return journalAppend(record, (size_t) length, seq);
+}
+
+void journalReplay(AccountTable *table, const char *filename) {
+    unsigned long long lastSeq = table->journalSeq;
+    if (journal.nextSeq > lastSeq + 1) {
+        lastSeq = journal.nextSeq - 1; // Already replayed an older journal file
+    }
+    journal.nextSeq = lastSeq + 1;
+
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        return;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *buffer = (char *)malloc(fileSize + 1);
+    if (buffer == NULL) {
+        perror("Error allocating memory. Function journalReplay()");
+        fclose(file);
+        exit(EXIT_FAILURE);
+    }
+    size_t bytesRead = fread(buffer, 1, fileSize, file);
+    buffer[bytesRead] = '\0';
+    fclose(file);
+
+    size_t offset = 0;
+    while (offset < bytesRead) {
+        char *end = memchr(buffer + offset, '\n', bytesRead - offset);
+        if (end == NULL) {
+            break; // Torn record from a crash in the middle of a write
+        }
+        *end = '\0';
+
+        // A complete record was fsynced and may have been acknowledged, so one that cannot be applied (damage, or a
+        // record type this version does not know) stops the load instead of being dropped with everything after it
+        unsigned long long seq;
+        int valid = sscanf(buffer + offset, "%llu", &seq) == 1;
+        if (valid && seq > lastSeq) {
+            valid = journalApply(table, buffer + offset);
+            lastSeq = seq;
+        }
+        if (!valid) {
+            fprintf(stderr, "Error replaying journal %s at byte %zu: \"%s\". Function journalReplay()\n", filename,
+                    offset, buffer + offset);
+            exit(EXIT_FAILURE);
+        }
+        offset = (size_t) (end - buffer) + 1;
+    }
+
+    // Drop the torn record so new records are not appended behind it
+    if (offset < bytesRead && truncate(filename, (off_t) offset) != 0) {
+        perror("Error truncating journal. Function journalReplay()");
+        exit(EXIT_FAILURE);
+    }
+
+    journal.nextSeq = lastSeq + 1;
+    free(buffer);
+}
+
+int journalApply(AccountTable *table, const char *record) {
+    unsigned long long seq;
+    char op;
+    int accountNumber;
+    int consumed;
+
+    if (sscanf(record, "%llu %c %d %n", &seq, &op, &accountNumber, &consumed) != 3) {
+        return 0;
+    }
+    const char *rest = record + consumed;
+    size_t row = indexFind(accountNumber);
+
+    switch (op) {
+        case 'D':
+        case 'W': {
+            // Older journals hold these as %.17g doubles; parseAmount rounds them to the cent
+            char amountText[64], balanceText[64];
+            long long amount, balance;
+            if (row == NO_ROW || sscanf(rest, "%63s %63s", amountText, balanceText) != 2 ||
+                !parseAmount(amountText, &amount) || !parseAmount(balanceText, &balance)) {
+                return 0;
+            }
+            table->balances[row] = balance;
+            return 1;
+        }
+        case 'T': {
+            char amountText[64], balanceText[64], toBalanceText[64];
+            int toAccountNumber;
+            long long amount, balance, toBalance;
+            if (row == NO_ROW || sscanf(rest, "%d %63s %63s %63s", &toAccountNumber, amountText, balanceText,
+                                        toBalanceText) != 4 ||
+                !parseAmount(amountText, &amount) || !parseAmount(balanceText, &balance) ||
+                !parseAmount(toBalanceText, &toBalance)) {
+                return 0;
+            }
+            size_t toRow = indexFind(toAccountNumber);
+            if (toRow == NO_ROW) {
+                return 0;
+            }
+            table->balances[row] = balance;
+            table->balances[toRow] = toBalance;
+            return 1;
+        }
+        case 'P': {
+            char pin[MAX_NAME_LENGTH];
+            if (row == NO_ROW || sscanf(rest, "%39s", pin) != 1) {
+                return 0;
+            }
+            tableSetString(table, row, FIELD_PIN, pin);
+            return 1;
+        }
+        case 'C': {
+            if (row != NO_ROW) {
+                tableRemove(table, row);
+            }
+            row = tableAddRecord(table, rest, strlen(rest));
+            if (row == NO_ROW) {
+                return 0;
+            }
+            indexInsert(accountNumber, row);
+            return 1;
+        }
+        case 'X':
+            if (row != NO_ROW) {
+                tableRemove(table, row);
+            }
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+void journalRotate() {
+    // Records already handed out belong to the old file, so write them there before switching
+    pthread_mutex_lock(&journal.lock);
+    journalFlushLocked();
+    if (close(journal.fd) != 0 || rename(JOURNAL_FILE, JOURNAL_OLD_FILE) != 0) {
+        perror("Error rotating journal. Function journalRotate()");
+        exit(EXIT_FAILURE);
+    }
+    journalOpen(JOURNAL_FILE);
+    pthread_mutex_unlock(&journal.lock);
+}
+
+void checkpoint(AccountTable *table) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    /* A child process writes the snapshot from a copy-on-write image of the table taken at the fork, so the lock is
+       only held for the fork and the menu carries on while the child encodes and writes. The extra memory is the
+       pages the menu changes in the meantime, not a copy of the bank. */
+    int fd = snapshotCreate();
+    fflush(NULL); // Otherwise the child would write out buffered output a second time
+    pthread_mutex_lock(&bankMutex);
+    table->journalSeq = journal.nextSeq - 1;
+    journalRotate();
+    pid_t writer = fork();
+    if (writer == 0) {
+        saveToFile(table, fd);
+        _exit(EXIT_SUCCESS);
+    }
+    checkpointer.lastCheckpoint = time(NULL);
+    pthread_mutex_unlock(&bankMutex);
+    if (writer < 0) {
+        perror("Error starting snapshot writer. Function checkpoint()");
+        exit(EXIT_FAILURE);
+    }
+
+    int status;
+    while (waitpid(writer, &status, 0) < 0) {
+        if (errno != EINTR) {
+            perror("Error waiting for snapshot writer. Function checkpoint()");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        fprintf(stderr, "Error writing snapshot. Function checkpoint()\n");
+        exit(EXIT_FAILURE);
+    }
+    off_t bytes = lseek(fd, 0, SEEK_CUR); // The child wrote through the same file offset
+    snapshotCommit(fd, JSON_FILE);
+
+    // Every record in the old journal is now in the snapshot
+    if (unlink(JOURNAL_OLD_FILE) != 0 && errno != ENOENT) {
+        perror("Error removing journal. Function checkpoint()");
+        exit(EXIT_FAILURE);
+    }
+
+    if (verbose) {
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        fprintf(stderr, "Checkpoint: wrote %lld bytes in %.1f ms\n", (long long) bytes,
+                (double) (end.tv_sec - start.tv_sec) * 1000.0 + (double) (end.tv_nsec - start.tv_nsec) / 1e6);
+    }
+}
+
+void checkpointerStart(AccountTable *table) {
+    checkpointer.table = table;
+    checkpointer.stop = 0;
+    checkpointer.lastCheckpoint = time(NULL);
+    if (pthread_create(&checkpointer.thread, NULL, checkpointerRun, NULL) != 0) {
+        perror("Error starting checkpointer. Function checkpointerStart()");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void checkpointerStop() {
+    pthread_mutex_lock(&bankMutex);
+    checkpointer.stop = 1;
+    pthread_cond_signal(&checkpointer.wake);
+    pthread_mutex_unlock(&bankMutex);
+    pthread_join(checkpointer.thread, NULL);
+}
+
+void *checkpointerRun(void *arg) {
+    pthread_mutex_lock(&bankMutex);
+    while (!checkpointer.stop) {
+        struct timespec deadline = { checkpointer.lastCheckpoint + CHECKPOINT_INTERVAL_SECONDS, 0 };
+        if (journal.bytes < CHECKPOINT_JOURNAL_BYTES) {
+            pthread_cond_timedwait(&checkpointer.wake, &bankMutex, &deadline);
+        }
+        if (checkpointer.stop) {
+            break;
+        }
+
+        int due = journal.bytes >= CHECKPOINT_JOURNAL_BYTES ||
+                  (journal.bytes > 0 && time(NULL) >= checkpointer.lastCheckpoint + CHECKPOINT_INTERVAL_SECONDS);
+        if (!due) {
+            if (journal.bytes == 0 && time(NULL) >= checkpointer.lastCheckpoint + CHECKPOINT_INTERVAL_SECONDS) {
+                checkpointer.lastCheckpoint = time(NULL); // Nothing to do, wait another interval
+            }
+            continue;
+        }
+
+        pthread_mutex_unlock(&bankMutex);
+        checkpoint(checkpointer.table);
+        pthread_mutex_lock(&bankMutex);
+    }
+    pthread_mutex_unlock(&bankMutex);
+
+    return arg;
+}
+
+void delay(int number_of_seconds) {
+    int milli_seconds = 1000 * number_of_seconds;
+    clock_t start_time = clock();
+
+    while (clock() < start_time + milli_seconds);
+}
+
+int randomNumber() {
+    if (accountNumbers.usedBits == NULL) {
+        accountNumbersInit();
+    }
+    if (accountNumbers.used == ACCOUNT_NUMBER_MAX - ACCOUNT_NUMBER_MIN + 1) {
+        printf("No account numbers left\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // splitmix64, seeded once per run; rand() was never seeded and repeated the same numbers every run
+    unsigned long long z = (accountNumbers.seed += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+
+    int num = accountNumbersNextFree((size_t) (z % (ACCOUNT_NUMBER_MAX - ACCOUNT_NUMBER_MIN + 1)));
+    accountNumbersMark(num);
+    return num;
+}
+
+size_t reserveAccountNumbers(int *numbers, size_t count) {
+    size_t reserved = 0;
+    if (count == 0) {
+        return 0;
+    }
+
+    // Take the first number at random and the rest from the free numbers after it, a word at a time
+    numbers[reserved++] = randomNumber();
+    while (reserved < count && accountNumbers.used < ACCOUNT_NUMBER_MAX - ACCOUNT_NUMBER_MIN + 1) {
+        int num = accountNumbersNextFree((size_t) (numbers[reserved - 1] - ACCOUNT_NUMBER_MIN));
+        accountNumbersMark(num);
+        numbers[reserved++] = num;
+    }
+    return reserved;
+}
+
+void accountNumbersInit() {
+    size_t words = (ACCOUNT_NUMBER_MAX - ACCOUNT_NUMBER_MIN + 1 + 63) / 64;
+    size_t summaryWords = (words + 63) / 64;
+
+    accountNumbers.usedBits = calloc(words, sizeof(unsigned long long));
+    accountNumbers.fullWords = calloc(summaryWords, sizeof(unsigned long long));
+    if (accountNumbers.usedBits == NULL || accountNumbers.fullWords == NULL) {
+        perror("Error allocating memory. Function accountNumbersInit()");
+        exit(EXIT_FAILURE);
+    }
+    accountNumbers.used = 0;
+    accountNumbers.seed = (unsigned long long) time(NULL) ^ ((unsigned long long) getpid() << 32);
+
+    // Bits past the end of the range are never free
+    size_t rangeBits = ACCOUNT_NUMBER_MAX - ACCOUNT_NUMBER_MIN + 1;
+    if (rangeBits % 64 != 0) {
+        accountNumbers.usedBits[words - 1] |= ~0ull << (rangeBits % 64);
+    }
+    if (words % 64 != 0) {
+        accountNumbers.fullWords[summaryWords - 1] |= ~0ull << (words % 64);
+    }
+}
+
+void accountNumbersMark(int num) {
+    if (num < ACCOUNT_NUMBER_MIN || num > ACCOUNT_NUMBER_MAX) {
+        return;
+    }
+    if (accountNumbers.usedBits == NULL) {
+        accountNumbersInit();
+    }
+
+    size_t bit = (size_t) (num - ACCOUNT_NUMBER_MIN);
+    unsigned long long mask = 1ull << (bit % 64);
+    if (accountNumbers.usedBits[bit / 64] & mask) {
+        return;
+    }
+    accountNumbers.usedBits[bit / 64] |= mask;
+    accountNumbers.used++;
+    if (accountNumbers.usedBits[bit / 64] == ~0ull) {
+        accountNumbers.fullWords[bit / 4096] |= 1ull << ((bit / 64) % 64);
+    }
+}
+
+void accountNumbersRelease(int num) {
+    if (num < ACCOUNT_NUMBER_MIN || num > ACCOUNT_NUMBER_MAX || accountNumbers.usedBits == NULL) {
+        return;
+    }
+
+    size_t bit = (size_t) (num - ACCOUNT_NUMBER_MIN);
+    unsigned long long mask = 1ull << (bit % 64);
+    if (!(accountNumbers.usedBits[bit / 64] & mask)) {
+        return;
+    }
+    accountNumbers.usedBits[bit / 64] &= ~mask;
+    accountNumbers.used--;
+    accountNumbers.fullWords[bit / 4096] &= ~(1ull << ((bit / 64) % 64));
+}
+
+int accountNumbersNextFree(size_t bit) {
+    size_t words = (ACCOUNT_NUMBER_MAX - ACCOUNT_NUMBER_MIN + 1 + 63) / 64;
+    size_t summaryWords = (words + 63) / 64;
+    size_t word = bit / 64;
+
+    // Free number in the same word at or after the starting bit
+    unsigned long long freeBits = ~accountNumbers.usedBits[word] & (~0ull << (bit % 64));
+    if (freeBits == 0) {
+        // Otherwise the first word after it that is not full, found through the summary bits (wrapping around)
+        size_t summary = (word + 1) / 64 % summaryWords;
+        unsigned long long open = ~accountNumbers.fullWords[summary] & (~0ull << ((word + 1) % 64));
+        while (open == 0) {
+            summary = (summary + 1) % summaryWords;
+            open = ~accountNumbers.fullWords[summary];
+        }
+        word = summary * 64 + (size_t) __builtin_ctzll(open);
+        freeBits = ~accountNumbers.usedBits[word];
+    }
+
+    return ACCOUNT_NUMBER_MIN + (int) (word * 64 + (size_t) __builtin_ctzll(freeBits));
+}
+
+size_t userAccount(const Account *user, const AccountTable *table) {
+    size_t row = indexFind((int) strtol(user->accountNumber, NULL, 10));
+    if (row == NO_ROW || strcmp(user->pin, tableString(table, row, FIELD_PIN)) != 0) {
+        return NO_ROW;
+    }
+    return row;
+}
+
+/* Fibonacci hashing spreads the sequential-looking account numbers over the whole table */
+size_t indexSlot(int accountNumber, size_t capacity) {
+    return (size_t) (((unsigned long long) (unsigned int) accountNumber * 11400714819323198485ull) >> 32) & (capacity - 1);
+}
+
+void indexResize(size_t capacity) {
+    IndexSlot *oldSlots = accountIndex.slots;
+    size_t oldCapacity = accountIndex.capacity;
+
+    accountIndex.slots = calloc(capacity, sizeof(IndexSlot));
+    if (accountIndex.slots == NULL) {
+        perror("Error allocating memory. Function indexResize()");
+        exit(EXIT_FAILURE);
+    }
+    accountIndex.capacity = capacity;
+    accountIndex.count = 0;
+
+    for (size_t i = 0; i < oldCapacity; i++) {
+        if (oldSlots[i].accountNumber != 0) {
+            indexInsert(oldSlots[i].accountNumber, oldSlots[i].row);
+        }
+    }
+    free(oldSlots);
+}
+
+void indexBuild(const AccountTable *table) {
+    size_t capacity = 16;
+
+    indexFree();
+    while (capacity < table->count * 2) {
+        capacity *= 2;
+    }
+    indexResize(capacity);
+
+    for (size_t row = 0; row < table->count; row++) {
+        indexInsert(table->accountNumbers[row], row);
+    }
+}
+
+void indexInsert(int accountNumber, size_t row) {
+    // Keep the load factor at or below 1/2 so probe sequences stay short
+    if ((accountIndex.count + 1) * 2 > accountIndex.capacity) {
+        indexResize(accountIndex.capacity == 0 ? 16 : accountIndex.capacity * 2);
+    }
+
+    size_t mask = accountIndex.capacity - 1;
+    size_t i = indexSlot(accountNumber, accountIndex.capacity);
+    while (accountIndex.slots[i].accountNumber != 0 && accountIndex.slots[i].accountNumber != accountNumber) {
+        i = (i + 1) & mask;
+    }
+    if (accountIndex.slots[i].accountNumber == 0) {
+        accountIndex.count++;
+        accountNumbersMark(accountNumber);
+    }
+    accountIndex.slots[i].accountNumber = accountNumber;
+    accountIndex.slots[i].row = row;
+}
+
+size_t indexFind(int accountNumber) {
+    if (accountIndex.capacity == 0 || accountNumber == 0) {
+        return NO_ROW;
+    }
+
+    size_t mask = accountIndex.capacity - 1;
+    size_t i = indexSlot(accountNumber, accountIndex.capacity);
+    while (accountIndex.slots[i].accountNumber != 0) {
+        if (accountIndex.slots[i].accountNumber == accountNumber) {
+            return accountIndex.slots[i].row;
+        }
+        i = (i + 1) & mask;
+    }
+    return NO_ROW;
+}
+
+void indexRemove(int accountNumber) {
+    if (accountIndex.capacity == 0 || accountNumber == 0) {
+        return;
+    }
+
+    size_t mask = accountIndex.capacity - 1;
+    size_t i = indexSlot(accountNumber, accountIndex.capacity);
+    while (accountIndex.slots[i].accountNumber != accountNumber) {
+        if (accountIndex.slots[i].accountNumber == 0) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+
+    // Backward-shift deletion: pull later members of the cluster into the hole so no tombstones are needed
+    size_t hole = i;
+    for (size_t j = (i + 1) & mask; accountIndex.slots[j].accountNumber != 0; j = (j + 1) & mask) {
+        size_t home = indexSlot(accountIndex.slots[j].accountNumber, accountIndex.capacity);
+        if (((j - home) & mask) >= ((j - hole) & mask)) {
+            accountIndex.slots[hole] = accountIndex.slots[j];
+            hole = j;
+        }
+    }
+    accountIndex.slots[hole].accountNumber = 0;
+    accountIndex.slots[hole].row = NO_ROW;
+    accountIndex.count--;
+    accountNumbersRelease(accountNumber);
+}
+
+void indexFree() {
+    free(accountIndex.slots);
+    accountIndex.slots = NULL;
+    accountIndex.capacity = 0;
+    accountIndex.count = 0;
+}
+
+void *poolMalloc(size_t size) {
+    size_t *block;
+
+    if (size > POOL_MAX_SIZE) {
+        block = malloc(size + sizeof(size_t));
+        if (block == NULL) {
+            return NULL;
+        }
+        block[0] = POOL_CLASSES; // Not from a chunk
+        return block + 1;
+    }
+
+    if (poolCache.generation != pool.generation) {
+        memset(&poolCache, 0, sizeof(poolCache));
+        poolCache.generation = pool.generation;
+    }
+
+    size_t sizeClass = size == 0 ? 0 : (size - 1) / 8;
+    block = poolCache.freeLists[sizeClass];
+    if (block != NULL) {
+        poolCache.freeLists[sizeClass] = (size_t *) block[1];
+        return block + 1;
+    }
+
+    size_t blockSize = (sizeClass + 2) * 8; // Header plus the class size
+    if (poolCache.cursor == NULL || (size_t) (poolCache.end - poolCache.cursor) < blockSize) {
+        PoolChunk *chunk = malloc(POOL_CHUNK_SIZE);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        pthread_mutex_lock(&pool.lock);
+        chunk->next = pool.chunks;
+        pool.chunks = chunk;
+        pool.chunkCount++;
+        pthread_mutex_unlock(&pool.lock);
+
+        // The tail of the previous chunk is abandoned; it is at most one block
+        poolCache.cursor = (char *) (chunk + 1);
+        poolCache.end = (char *) chunk + POOL_CHUNK_SIZE;
+    }
+
+    block = (size_t *) poolCache.cursor;
+    poolCache.cursor += blockSize;
+    block[0] = sizeClass;
+    return block + 1;
+}
+
+void poolFree(void *pointer) {
+    if (pointer == NULL) {
+        return;
+    }
+
+    size_t *block = (size_t *) pointer - 1;
+    if (block[0] == POOL_CLASSES) {
+        free(block);
+        return;
+    }
+    if (poolCache.generation != pool.generation) {
+        memset(&poolCache, 0, sizeof(poolCache));
+        poolCache.generation = pool.generation;
+    }
+
+    block[1] = (size_t) poolCache.freeLists[block[0]];
+    poolCache.freeLists[block[0]] = block;
+}
+
+void poolRelease() {
+    pthread_mutex_lock(&pool.lock);
+    while (pool.chunks != NULL) {
+        PoolChunk *next = pool.chunks->next;
+        free(pool.chunks);
+        pool.chunks = next;
+    }
+    pool.chunkCount = 0;
+    pool.generation++;
+    pthread_mutex_unlock(&pool.lock);
+}
+
+void internKeys() {
+    const char *keys[] = {
+        KEY_ACCOUNTS, KEY_JOURNAL_SEQ, KEY_NAME, KEY_COUNTRY, KEY_STATE, KEY_CITY, KEY_STREET, KEY_HOUSE_NUMBER,
+        KEY_PHONE, KEY_PIN, KEY_SECURITY_QUESTION, KEY_SECURITY_ANSWER, KEY_ACCOUNT_NUMBER, KEY_BALANCE
+    };
+
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        cJSON_InternKey(keys[i]);
+    }
+    cJSON_SetKeyInterning(1);
+}
@@ -0,0 +1,37 @@
+#!/bin/sh
+# Batch input checks: unknown operation codes are reported as such, and account creations with a field longer than
+# the menu's buffers are refused.
+# Run from the repository root: sh tests/batch_test.sh
+
+set -e
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+gcc -O2 -pthread -o "$dir/bank" main.c -lm
+
+cat > "$dir/accounts.json" <<'JSON'
+{"accounts":[{"name":"Ann","country":"IN","state":"TS","city":"Hyd","street":"Main","houseNumber":"1","phone":"9999","pin":"1111","securityQuestion":"pet?","securityAnswer":"dog","accountNumber":10000001,"balance":100}],"journalSeq":0}
+JSON
+long=$(printf '%072d' 0)
+cat > "$dir/ops.txt" <<OPS
+X 10000001
+C Carl IN TS Hyd Main 3 9999 3333 1 pet?|fish
+C $long IN TS Hyd Main 3 9999 3333 1 pet?|fish
+C Carl IN TS Hyd Main 3 1234567890123456 3333 1 pet?|fish
+C Carl IN TS Hyd Main 3 9999 3333 1 pet?|$long
+OPS
+(cd "$dir" && ./bank --format=compact --batch=ops.txt --out=results.txt 2> /dev/null)
+
+fail=0
+for expected in '^1 ERROR unknown operation$' '^2 OK [0-9]* 1$' '^3 ERROR invalid field$' '^4 ERROR invalid field$' \
+                '^5 ERROR invalid field$'; do
+    if ! grep -q "$expected" "$dir/results.txt"; then
+        echo "FAIL: results lack $expected"
+        fail=1
+    fi
+done
+
+if [ "$fail" -ne 0 ]; then
+    cat "$dir/results.txt"
+    exit 1
+fi
+echo "PASS: batch_test"
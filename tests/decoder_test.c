@@ -0,0 +1,144 @@
+/*
+   Checks the schema decoder (decodeAccountDocument) against the generic path it stands in for (cJSON parse, then
+   tableLoadJSON): snapshots cJSON prints, pretty and compact, with escapes in every string field must be decoded
+   to the same table; \u escapes, extra keys and reordered keys must make the decoder give up so cJSON loads them;
+   account numbers outside [ACCOUNT_NUMBER_MIN, ACCOUNT_NUMBER_MAX] or not integers must be refused by both.
+   Build and run from the repository root:
+    gcc -O2 -pthread -o decoder_test tests/decoder_test.c -lm && ./decoder_test
+*/
+#define main bankMain
+#include "../main.c"
+#undef main
+
+static unsigned long long seed = 0x9E3779B97F4A7C15ull;
+static size_t failures = 0;
+
+static unsigned long long nextRandom() {
+    unsigned long long z = (seed += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// A string with the characters cJSON escapes with a backslash but never as \u, plus multi-byte UTF-8
+static void randomString(char *out, size_t size) {
+    static const char *const pieces[] = {
+        "a", "Z", "7", " ", "\"", "\\", "/", "\b", "\f", "\n", "\r", "\t", "\xc3\xa9", "\xe2\x82\xb9", "|", "{", "}"
+    };
+    size_t length = nextRandom() % 12;
+    out[0] = '\0';
+    for (size_t i = 0; i < length && strlen(out) + 4 < size; i++) {
+        strcat(out, pieces[nextRandom() % (sizeof(pieces) / sizeof(pieces[0]))]);
+    }
+}
+
+static cJSON *randomDocument(size_t accounts) {
+    cJSON *json = cJSON_CreateObject();
+    cJSON *array = cJSON_AddArrayToObject(json, KEY_ACCOUNTS);
+    for (size_t i = 0; i < accounts; i++) {
+        cJSON *account = cJSON_CreateObject();
+        for (int field = 0; field < ACCOUNT_STRING_FIELDS; field++) {
+            char value[64];
+            randomString(value, sizeof(value));
+            cJSON_AddStringToObject(account, ACCOUNT_STRING_KEYS[field], value);
+        }
+        long long cents = (long long) (nextRandom() % 100000000000ull) - 1000;
+        unsigned long long offset = nextRandom() % (ACCOUNT_NUMBER_MAX - ACCOUNT_NUMBER_MIN + 1);
+        cJSON_AddNumberToObject(account, KEY_ACCOUNT_NUMBER, ACCOUNT_NUMBER_MIN + (double) offset);
+        cJSON_AddNumberToObject(account, KEY_BALANCE, (double) cents / MINOR_UNITS);
+        cJSON_AddItemToArray(array, account);
+    }
+    cJSON_AddNumberToObject(json, KEY_JOURNAL_SEQ, (double) (nextRandom() % 1000000000));
+    return json;
+}
+
+static int sameTables(const AccountTable *a, const AccountTable *b) {
+    if (a->count != b->count || a->journalSeq != b->journalSeq) {
+        return 0;
+    }
+    for (size_t row = 0; row < a->count; row++) {
+        if (a->accountNumbers[row] != b->accountNumbers[row] || a->balances[row] != b->balances[row]) {
+            return 0;
+        }
+        for (int field = 0; field < ACCOUNT_STRING_FIELDS; field++) {
+            if (strcmp(tableString(a, row, field), tableString(b, row, field)) != 0) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// Loads text both ways; expectDecoded and expectLoaded say whether the decoder and the cJSON path should accept it
+static void check(const char *name, const char *text, int expectDecoded, int expectLoaded) {
+    AccountTable decoded = { 0 };
+    AccountTable loaded = { 0 };
+    int wasDecoded = decodeAccountDocument(text, strlen(text), &decoded);
+    cJSON *json = cJSON_Parse(text);
+    int wasLoaded = json != NULL && tableLoadJSON(&loaded, json);
+    cJSON_Delete(json);
+
+    if (wasDecoded != expectDecoded || wasLoaded != expectLoaded) {
+        printf("FAIL %s: decoder %s, cJSON path %s\n", name, wasDecoded ? "accepted" : "gave up",
+               wasLoaded ? "accepted" : "refused");
+        failures++;
+    } else if (wasDecoded && !sameTables(&decoded, &loaded)) {
+        printf("FAIL %s: the decoder and the cJSON path loaded different tables\n", name);
+        failures++;
+    }
+    tableFree(&decoded);
+    tableFree(&loaded);
+}
+
+#define ACCOUNT_FIELDS "\"country\":\"IN\",\"state\":\"TS\",\"city\":\"Hyd\",\"street\":\"Main\"," \
+    "\"houseNumber\":\"1\",\"phone\":\"9999\",\"pin\":\"1111\"," \
+    "\"securityQuestion\":\"pet?\",\"securityAnswer\":\"dog\","
+
+static const char ACCOUNT_HEAD[] = "{\"accounts\":[{\"name\":\"Ann\"," ACCOUNT_FIELDS;
+
+static void checkAccount(const char *name, const char *tail, int expectDecoded, int expectLoaded) {
+    char text[1024];
+    snprintf(text, sizeof(text), "%s%s", ACCOUNT_HEAD, tail);
+    check(name, text, expectDecoded, expectLoaded);
+}
+
+int main() {
+    internKeys();
+
+    for (int round = 0; round < 200; round++) {
+        cJSON *json = randomDocument(1 + nextRandom() % 50);
+        char *pretty = cJSON_Print(json);
+        char *compact = cJSON_PrintUnformatted(json);
+        check("random pretty", pretty, 1, 1);
+        check("random compact", compact, 1, 1);
+        cJSON_free(pretty);
+        cJSON_free(compact);
+        cJSON_Delete(json);
+    }
+
+    checkAccount("lowest account number", "\"accountNumber\":10000000,\"balance\":1}],\"journalSeq\":0}", 1, 1);
+    checkAccount("highest account number", "\"accountNumber\":99999999,\"balance\":1}],\"journalSeq\":0}", 1, 1);
+    checkAccount("whitespace", "\"accountNumber\" : 10000001 ,\n\"balance\":\t1.5 } ] , \"journalSeq\" : 3 }", 1, 1);
+    check("no accounts", "{\"accounts\":[],\"journalSeq\":7}", 1, 1);
+
+    // Left to cJSON
+    check("\\u escape",
+          "{\"accounts\":[{\"name\":\"Ren\\u00e9e\"," ACCOUNT_FIELDS "\"accountNumber\":10000001,\"balance\":1}],"
+          "\"journalSeq\":0}", 0, 1);
+    checkAccount("extra key", "\"accountNumber\":10000001,\"balance\":1,\"nickname\":\"A\"}],\"journalSeq\":0}", 0, 1);
+    checkAccount("reordered keys", "\"balance\":1,\"accountNumber\":10000001}],\"journalSeq\":0}", 0, 1);
+    checkAccount("exponent balance", "\"accountNumber\":10000001,\"balance\":1e2}],\"journalSeq\":0}", 1, 1);
+
+    // Refused by both
+    checkAccount("account number past int", "\"accountNumber\":12345678901,\"balance\":1}],\"journalSeq\":0}", 0, 0);
+    checkAccount("account number below range", "\"accountNumber\":9999999,\"balance\":1}],\"journalSeq\":0}", 0, 0);
+    checkAccount("negative account number", "\"accountNumber\":-10000001,\"balance\":1}],\"journalSeq\":0}", 0, 0);
+    checkAccount("fractional account number", "\"accountNumber\":10000001.5,\"balance\":1}],\"journalSeq\":0}", 0, 0);
+
+    if (failures != 0) {
+        printf("FAIL: %zu failures\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("PASS: decoder_test\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,43 @@
+#!/bin/sh
+# Journal replay: a torn last record (no newline) is dropped, but a complete record that cannot be applied stops
+# the load and leaves the journal as it was, records after it included.
+# Run from the repository root: sh tests/journal_test.sh
+
+set -e
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+gcc -O2 -pthread -o "$dir/bank" main.c -lm
+
+cat > "$dir/bank.json" <<'JSON'
+{"accounts":[{"name":"Ann","country":"IN","state":"TS","city":"Hyd","street":"Main","houseNumber":"1","phone":"9999","pin":"1111","securityQuestion":"pet?","securityAnswer":"dog","accountNumber":10000001,"balance":100},{"name":"Bob","country":"IN","state":"TS","city":"Hyd","street":"Main","houseNumber":"2","phone":"9999","pin":"2222","securityQuestion":"pet?","securityAnswer":"cat","accountNumber":10000002,"balance":10}],"journalSeq":0}
+JSON
+: > "$dir/ops.txt"
+fail=0
+
+# An empty batch loads the bank, replays the journal and saves a snapshot
+cp "$dir/bank.json" "$dir/accounts.json"
+printf '1 D 10000001 5 105\n2 D 10000002 1 1' > "$dir/accounts.journal"
+(cd "$dir" && ./bank --format=compact --batch=ops.txt --out=results.txt 2> /dev/null)
+for expected in '"accountNumber":10000001,"balance":105' '"accountNumber":10000002,"balance":10'; do
+    if ! grep -q "$expected" "$dir/accounts.json"; then
+        echo "FAIL: after a torn record the snapshot lacks $expected"
+        fail=1
+    fi
+done
+
+cp "$dir/bank.json" "$dir/accounts.json"
+printf '1 D 10000001 5 105\n2 Z 10000001\n3 D 10000002 1 11\n' > "$dir/accounts.journal"
+cp "$dir/accounts.journal" "$dir/journal.expected"
+if (cd "$dir" && ./bank --format=compact --batch=ops.txt --out=results.txt 2> /dev/null); then
+    echo "FAIL: a journal with a bad record was loaded"
+    fail=1
+fi
+if ! cmp -s "$dir/accounts.journal" "$dir/journal.expected"; then
+    echo "FAIL: the journal with a bad record was changed"
+    fail=1
+fi
+
+if [ "$fail" -ne 0 ]; then
+    exit 1
+fi
+echo "PASS: journal_test"
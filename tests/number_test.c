@@ -0,0 +1,106 @@
+/*
+   Checks cJSON's parse_number_fast (the Clinger fast path in parse_number) against strtod, bit for bit, on the
+   boundary cases of the fast path and on a seeded random corpus. Every input the fast path accepts must give the
+   same double and consume the same bytes as strtod; every input must parse through cJSON_Parse to strtod's value.
+   Build and run from the repository root:
+    gcc -O2 -o number_test tests/number_test.c -lm && ./number_test
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../cJSON.c"
+
+static unsigned long long seed = 0x9E3779B97F4A7C15ull;
+static size_t checked = 0;
+static size_t fast = 0;
+static size_t failures = 0;
+
+static unsigned long long nextRandom() {
+    // splitmix64, the generator main.c uses for account numbers
+    unsigned long long z = (seed += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static void check(const char *text) {
+    char *end = NULL;
+    double expected = strtod(text, &end);
+    double actual = 0;
+    size_t consumed = parse_number_fast((const unsigned char *) text, strlen(text), &actual);
+    checked++;
+
+    if (consumed != 0) {
+        fast++;
+        if (memcmp(&actual, &expected, sizeof(double)) != 0 || consumed != (size_t) (end - text)) {
+            printf("FAIL fast path: %s -> %.17g (%zu bytes), strtod %.17g (%zu bytes)\n", text, actual, consumed,
+                   expected, (size_t) (end - text));
+            failures++;
+        }
+    }
+
+    cJSON *item = cJSON_Parse(text);
+    if (!cJSON_IsNumber(item) || memcmp(&item->valuedouble, &expected, sizeof(double)) != 0) {
+        printf("FAIL cJSON_Parse: %s -> %.17g, strtod %.17g\n", text, item == NULL ? 0.0 : item->valuedouble, expected);
+        failures++;
+    }
+    cJSON_Delete(item);
+}
+
+// digits significant digits, the decimal point after point of them (none if point >= digits), then e<exponent>
+static void checkGenerated(int digits, int point, int exponent, int negative) {
+    char text[64];
+    size_t length = 0;
+    if (negative) {
+        text[length++] = '-';
+    }
+    for (int i = 0; i < digits; i++) {
+        if (i == point && i > 0) {
+            text[length++] = '.';
+        }
+        text[length++] = (char) ('0' + (i == 0 ? 1 + nextRandom() % 9 : nextRandom() % 10));
+    }
+    if (exponent != 0) {
+        length += (size_t) snprintf(text + length, sizeof(text) - length, "e%d", exponent);
+    }
+    text[length] = '\0';
+    check(text);
+}
+
+int main() {
+    const char *cases[] = {
+        // Zero and signs
+        "0", "-0", "0.0", "-0.0", "0e0", "-0e5", "0.000",
+        // Around 2^53: the fast path stops at 15 digits, these must fall back or match
+        "9007199254740991", "9007199254740992", "9007199254740993", "900719925474099", "9007199254740.992",
+        "4503599627370496", "4503599627370497",
+        // Exponent limits of the exact powers of ten
+        "1e22", "1e23", "1e-22", "1e-23", "123456789012345e22", "123456789012345e-22", "1.23456789012345e22",
+        "9.99999999999999e22", "1E+22", "1E-022", "1e21", "1e-21", "5e-22", "5e-23",
+        // 15 to 19 significant digits
+        "123456789012345", "1234567890123456", "12345678901234567", "123456789012345678",
+        "1234567890123456789", "0.123456789012345", "0.1234567890123456", "12345678.9012345678",
+        "999999999999999", "9999999999999999", "99999999999999999", "-999999999999999e-5",
+        // Subnormals and the edges of the double range
+        "4.9e-324", "5e-324", "2.2250738585072009e-308", "2.2250738585072014e-308", "1e-400", "1.7976931348623157e308",
+        "1e309",
+        // Typical account data
+        "12345678", "99999999", "510.35", "3235.12", "0.1", "0.01", "1000000.99",
+        // Leading and trailing zeros
+        "000001", "0.000000000000001", "100000000000000000000000", "1.500000000000000000000",
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        check(cases[i]);
+    }
+
+    for (int i = 0; i < 2000000; i++) {
+        int digits = 1 + (int) (nextRandom() % 19);
+        int point = (int) (nextRandom() % (unsigned long long) (digits + 4));
+        int exponent = nextRandom() % 3 == 0 ? 0 : (int) (nextRandom() % 61) - 30;
+        checkGenerated(digits, point, exponent, (int) (nextRandom() % 2));
+    }
+
+    printf("%s: %zu inputs, %zu on the fast path, %zu failures\n", failures == 0 ? "PASS" : "FAIL", checked, fast,
+           failures);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,48 @@
+#!/bin/sh
+# Amounts that would overflow a balance are refused as invalid, from the menu and from a batch, and leave the
+# balances as they were.
+# Run from the repository root: sh tests/overflow_test.sh
+
+set -e
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+gcc -O2 -pthread -o "$dir/bank" main.c -lm
+
+cat > "$dir/bank.json" <<'JSON'
+{"accounts":[{"name":"Ann","country":"IN","state":"TS","city":"Hyd","street":"Main","houseNumber":"1","phone":"9999","pin":"1111","securityQuestion":"pet?","securityAnswer":"dog","accountNumber":10000001,"balance":100},{"name":"Bob","country":"IN","state":"TS","city":"Hyd","street":"Main","houseNumber":"2","phone":"9999","pin":"2222","securityQuestion":"pet?","securityAnswer":"cat","accountNumber":10000002,"balance":92233720368547758}],"journalSeq":0}
+JSON
+cp "$dir/bank.json" "$dir/accounts.json"
+fail=0
+
+# Log in as 10000001, deposit the largest amount there is, then transfer 50 to 10000002, which is already at it
+printf '10000001\n1111\n3\n92233720368547758\n10\n10000002\n50\n9\n' > "$dir/input"
+(cd "$dir" && ./bank --format=compact < input > output)
+refused=$(grep -o "Invalid amount" "$dir/output" | wc -l)
+if [ "$refused" -ne 2 ]; then
+    echo "FAIL: expected 2 refused menu operations, got $refused"
+    fail=1
+fi
+
+cp "$dir/bank.json" "$dir/accounts.json"
+rm -f "$dir/accounts.journal"
+printf 'D 10000002 1\nT 10000001 10000002 1\nD 10000001 92233720368547758\n' > "$dir/ops.txt"
+(cd "$dir" && ./bank --format=compact --batch=ops.txt --out=results.txt 2> /dev/null)
+for expected in '1 ERROR invalid amount' '2 ERROR invalid amount' '3 ERROR invalid amount'; do
+    if ! grep -qx "$expected" "$dir/results.txt"; then
+        echo "FAIL: batch results lack $expected"
+        fail=1
+    fi
+done
+
+for expected in '"accountNumber":10000001,"balance":100' '"accountNumber":10000002,"balance":92233720368547758'; do
+    if ! grep -q "$expected" "$dir/accounts.json"; then
+        echo "FAIL: snapshot lacks $expected"
+        fail=1
+    fi
+done
+
+if [ "$fail" -ne 0 ]; then
+    cat "$dir/output" "$dir/results.txt" "$dir/accounts.json"
+    exit 1
+fi
+echo "PASS: overflow_test"
@@ -0,0 +1,119 @@
+/*
+   Checks cJSON's print_short_decimal (the shortest-decimal path in print_number) against the sprintf path it
+   replaces ("%1.15g", falling back to "%1.17g" when that does not round-trip), byte for byte: on random doubles of
+   every magnitude, on short decimals m / 10^k, on near-ties where the 16th significant digit is a 5, on the
+   neighbours of decimals and on the 1e-4 and 1e15 edges of the fast path. Every number printed through
+   cJSON_PrintUnformatted must also match.
+   Build and run from the repository root:
+    gcc -O2 -o print_test tests/print_test.c -lm && ./print_test
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../cJSON.c"
+
+static unsigned long long seed = 0x9E3779B97F4A7C15ull;
+static size_t checked = 0;
+static size_t fast = 0;
+static size_t failures = 0;
+
+static unsigned long long nextRandom() {
+    // splitmix64, the generator main.c uses for account numbers
+    unsigned long long z = (seed += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// print_number as it was before print_short_decimal, for a value that is not an int
+static void printWithSprintf(char *buffer, double d) {
+    double test = 0.0;
+    sprintf(buffer, "%1.15g", d);
+    if ((sscanf(buffer, "%lg", &test) != 1) || !compare_double(test, d)) {
+        sprintf(buffer, "%1.17g", d);
+    }
+}
+
+static void check(double d) {
+    char expected[32];
+    unsigned char actual[32];
+    if (isnan(d) || isinf(d)) {
+        return;
+    }
+    checked++;
+
+    printWithSprintf(expected, d);
+    size_t length = print_short_decimal(actual, d);
+    if (length != 0) {
+        fast++;
+        actual[length] = '\0';
+        if (strcmp((const char *) actual, expected) != 0) {
+            printf("FAIL print_short_decimal: %.17g -> %s, sprintf %s\n", d, actual, expected);
+            failures++;
+        }
+    }
+
+    // The whole print_number, the int branch included
+    cJSON *item = cJSON_CreateNumber(d);
+    char *printed = cJSON_PrintUnformatted(item);
+    if (d == (double) item->valueint) {
+        sprintf(expected, "%d", item->valueint);
+    }
+    if (printed == NULL || strcmp(printed, expected) != 0) {
+        printf("FAIL cJSON_PrintUnformatted: %.17g -> %s, expected %s\n", d, printed == NULL ? "(null)" : printed,
+               expected);
+        failures++;
+    }
+    cJSON_free(printed);
+    cJSON_Delete(item);
+}
+
+static void checkWithNeighbours(double d) {
+    check(d);
+    check(-d);
+    check(nextafter(d, 0));
+    check(nextafter(d, INFINITY));
+}
+
+static double powerOfTen(int exponent) {
+    char text[16];
+    snprintf(text, sizeof(text), "1e%d", exponent);
+    return strtod(text, NULL);
+}
+
+int main() {
+    // The edges of the fast path and typical amounts
+    const double cases[] = {
+        1e-4, 1e15, 999999999999999.0, 999999999999999.9, 99999999999999.99, 0.0001, 0.00010000000000000001,
+        0.1, 0.2, 0.3, 0.01, 0.05, 510.35, 3235.12, 1000000.99, 123456789.12345, 0.123456789012345,
+        1.5, 2.5, 1e-5, 9.999999999999999e-5, 5e-324, 2.2250738585072014e-308, 1.7976931348623157e308,
+        2147483647.5, 2147483648.0, -2147483648.0, -2147483649.0, 9007199254740993.0, 0.0, -0.0,
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        checkWithNeighbours(cases[i]);
+    }
+
+    for (int i = 0; i < 250000; i++) {
+        // Any bit pattern: every exponent, subnormals included
+        unsigned long long bits = nextRandom();
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        check(d);
+
+        // m / 10^k with up to 15 digits, the values the fast path is for
+        unsigned long long m = nextRandom() % 1000000000000000ull;
+        int k = (int) (nextRandom() % 20);
+        checkWithNeighbours((double) m / powerOfTen(k));
+
+        // Near-ties: 15 digits, then a 5 and maybe more digits, scaled anywhere around the fast path's range
+        char text[64];
+        int exponent = (int) (nextRandom() % 24) - 8;
+        snprintf(text, sizeof(text), "%llu5%llue%d", 100000000000000ull + nextRandom() % 900000000000000ull,
+                 nextRandom() % 1000, exponent - 15);
+        checkWithNeighbours(strtod(text, NULL));
+    }
+
+    printf("%s: %zu doubles, %zu on the fast path, %zu failures\n", failures == 0 ? "PASS" : "FAIL", checked, fast,
+           failures);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
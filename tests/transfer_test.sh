@@ -0,0 +1,45 @@
+#!/bin/sh
+# Transfers from the menu: a negative or zero amount or a recipient that is not a number is refused and leaves both
+# balances as they were, a positive one moves the money.
+# Run from the repository root: sh tests/transfer_test.sh
+
+set -e
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+gcc -O2 -pthread -o "$dir/bank" main.c -lm
+
+cat > "$dir/accounts.json" <<'JSON'
+{"accounts":[{"name":"Ann","country":"IN","state":"TS","city":"Hyd","street":"Main","houseNumber":"1","phone":"9999","pin":"1111","securityQuestion":"pet?","securityAnswer":"dog","accountNumber":10000001,"balance":100},{"name":"Bob","country":"IN","state":"TS","city":"Hyd","street":"Main","houseNumber":"2","phone":"9999","pin":"2222","securityQuestion":"pet?","securityAnswer":"cat","accountNumber":10000002,"balance":10}],"journalSeq":0}
+JSON
+
+# Log in as 10000001, try -50, 0 and recipient "bob", transfer 25.5, then leave the menu (9), which saves the snapshot.
+# A recipient left unread in stdin would make the menu retry the transfer forever, hence the timeout.
+printf '10000001\n1111\n10\n10000002\n-50\n10\n10000002\n0\n10\nbob\n10\n10000002\n25.5\n9\n' > "$dir/input"
+if ! (cd "$dir" && timeout 10 ./bank --format=compact < input > output); then
+    echo "FAIL: the menu did not finish"
+    exit 1
+fi
+
+fail=0
+refused=$(grep -o "Invalid amount" "$dir/output" | wc -l)
+if [ "$refused" -ne 2 ]; then
+    echo "FAIL: expected 2 refused transfers, got $refused"
+    fail=1
+fi
+refused=$(grep -o "Invalid account number" "$dir/output" | wc -l)
+if [ "$refused" -ne 1 ]; then
+    echo "FAIL: expected 1 refused recipient, got $refused"
+    fail=1
+fi
+for expected in '"accountNumber":10000001,"balance":74.5' '"accountNumber":10000002,"balance":35.5'; do
+    if ! grep -q "$expected" "$dir/accounts.json"; then
+        echo "FAIL: snapshot lacks $expected"
+        fail=1
+    fi
+done
+
+if [ "$fail" -ne 0 ]; then
+    cat "$dir/accounts.json"
+    exit 1
+fi
+echo "PASS: transfer_test"